@@ -4,6 +4,38 @@
 
 // See Hardware Reference Manual for a description of all Blitter parameters.
 
+#define kBlitQueueSize 0x20 // power of two
+
+// Blitter registers for one blit, written in order with BLTSIZE last.
+typedef struct {
+  UWORD bltcon0;
+  UWORD bltcon1;
+  UWORD bltafwm;
+  UWORD bltalwm;
+  UWORD bltamod;
+  UWORD bltbmod;
+  UWORD bltcmod;
+  UWORD bltdmod;
+  UWORD bltadat;
+  UWORD bltbdat;
+  APTR bltapt;
+  APTR bltbpt;
+  APTR bltcpt;
+  APTR bltdpt;
+  UWORD bltsize;
+} Blit;
+
+static Blit* next_blit();
+static void queue_blit();
+static void start_blit(Blit* blit);
+
+static struct {
+  Blit queue[kBlitQueueSize];
+  volatile UWORD head; // blit running or next to run, advanced by blit_int
+  UWORD tail;          // next free entry
+  BOOL async;
+} g;
+
 void blit_copy(APTR src_base,
                UWORD src_stride_b,
                UWORD src_x,
@@ -53,7 +85,7 @@ void blit_copy(APTR src_base,
     right_word_mask = 0xFFFFU << MIN(0x10, ((start_x_word[0] + width_words) << 4) - (src_x + copy_w));
   }
 
-  gfx_wait_blit();
+  Blit* blit = next_blit();
 
   // A = Mask of bits inside copy region
   // B = Source data
@@ -61,18 +93,19 @@ void blit_copy(APTR src_base,
   // D = Destination data
   UWORD minterm = replace_bg ? 0xCA : 0xEA;
 
-  custom.bltcon0 = (ABS(shift) << BLTCON0_ASH0_SHF) | BLTCON0_USEB | BLTCON0_USEC | BLTCON0_USED | minterm;
-  custom.bltcon1 = (ABS(shift) << BLTCON1_BSH0_SHF) | (desc ? BLTCON1_DESC : 0);
-  custom.bltbmod = src_mod_b;
-  custom.bltcmod = dst_mod_b;
-  custom.bltdmod = dst_mod_b;
-  custom.bltafwm = (desc ? right_word_mask : left_word_mask);
-  custom.bltalwm = (desc ? left_word_mask : right_word_mask);
-  custom.bltadat = 0xFFFF;
-  custom.bltbpt = (APTR)src_start_b;
-  custom.bltcpt = (APTR)dst_start_b;
-  custom.bltdpt = (APTR)dst_start_b;
-  custom.bltsize = (copy_h << BLTSIZE_H0_SHF) | width_words;
+  blit->bltcon0 = (ABS(shift) << BLTCON0_ASH0_SHF) | BLTCON0_USEB | BLTCON0_USEC | BLTCON0_USED | minterm;
+  blit->bltcon1 = (ABS(shift) << BLTCON1_BSH0_SHF) | (desc ? BLTCON1_DESC : 0);
+  blit->bltbmod = src_mod_b;
+  blit->bltcmod = dst_mod_b;
+  blit->bltdmod = dst_mod_b;
+  blit->bltafwm = (desc ? right_word_mask : left_word_mask);
+  blit->bltalwm = (desc ? left_word_mask : right_word_mask);
+  blit->bltadat = 0xFFFF;
+  blit->bltbpt = (APTR)src_start_b;
+  blit->bltcpt = (APTR)dst_start_b;
+  blit->bltdpt = (APTR)dst_start_b;
+  blit->bltsize = (copy_h << BLTSIZE_H0_SHF) | width_words;
+  queue_blit();
 }
 
 void blit_rect(APTR dst_base,
@@ -116,24 +149,25 @@ void blit_rect(APTR dst_base,
     minterm |= set_bits ? 0xF0 : 0x00;
   }
 
-  gfx_wait_blit();
+  Blit* blit = next_blit();
 
   // A = Mask of bits inside copy region
   // B = Optional bitplane mask
   // C = Destination data (for region outside mask)
   // D = Destination data
-  custom.bltcon0 = BLTCON0_USEC | BLTCON0_USED | (mask_base ? BLTCON0_USEB : 0) | minterm;
-  custom.bltcon1 = 0;
-  custom.bltbmod = mask_mod_b;
-  custom.bltcmod = dst_mod_b;
-  custom.bltdmod = dst_mod_b;
-  custom.bltafwm = left_word_mask;
-  custom.bltalwm = right_word_mask;
-  custom.bltadat = 0xFFFF;
-  custom.bltbpt = (APTR)mask_start_b;
-  custom.bltcpt = (APTR)dst_start_b;
-  custom.bltdpt = (APTR)dst_start_b;
-  custom.bltsize = (height << BLTSIZE_H0_SHF) | width_words;
+  blit->bltcon0 = BLTCON0_USEC | BLTCON0_USED | (mask_base ? BLTCON0_USEB : 0) | minterm;
+  blit->bltcon1 = 0;
+  blit->bltbmod = mask_mod_b;
+  blit->bltcmod = dst_mod_b;
+  blit->bltdmod = dst_mod_b;
+  blit->bltafwm = left_word_mask;
+  blit->bltalwm = right_word_mask;
+  blit->bltadat = 0xFFFF;
+  blit->bltbpt = (APTR)mask_start_b;
+  blit->bltcpt = (APTR)dst_start_b;
+  blit->bltdpt = (APTR)dst_start_b;
+  blit->bltsize = (height << BLTSIZE_H0_SHF) | width_words;
+  queue_blit();
 }
 
 void blit_line(APTR dst_base,
@@ -152,111 +186,144 @@ void blit_line(APTR dst_base,
     ((((dx >= dy) && (y0 >= y1)) | ((dx < dy) && (x0 >= x1))) << 1) |
     ((dx >= dy) << 2);
 
-  gfx_wait_blit();
+  Blit* blit = next_blit();
 
   // A = Line parameters
   // C = Destination data (for region outside mask)
   // D = Destination data
-  custom.bltcon0 = ((x0 & 0xF) << BLTCON0_ASH0_SHF) | BLTCON0_USEA
+  blit->bltcon0 = ((x0 & 0xF) << BLTCON0_ASH0_SHF) | BLTCON0_USEA
                  | BLTCON0_USEC | BLTCON0_USED | (0xCA << BLTCON0_LF0_SHF);
-  custom.bltcon1 =
+  blit->bltcon1 =
     ((x0 & 0xF) << BLTCON1_TEX0_SHF) |
     ((((4 * dmin) - (2 * dmax)) < 0 ? 1 : 0) << BLTCON1_SIGN_SHF) |
     (octant << BLTCON1_AUL_SHF) |
     (0 << BLTCON1_SING_SHF) |
     BLTCON1_LINE;
-  custom.bltadat = 0x8000;
-  custom.bltbdat = 0xFFFF;
-  custom.bltafwm = 0xFFFF;
-  custom.bltalwm = 0xFFFF;
-  custom.bltamod = 4 * (dmin - dmax);
-  custom.bltbmod = 4 * dmin;
-  custom.bltcmod = dst_stride_b;
-  custom.bltdmod = dst_stride_b;
-  custom.bltapt = (APTR)(ULONG)((4 * dmin) - (2 * dmax));
-  custom.bltcpt = (APTR)dst_start;
-  custom.bltdpt = (APTR)dst_start;
-  custom.bltsize = ((dmax + 1) << BLTSIZE_H0_SHF) | (0x2 << BLTSIZE_W0_SHF);
+  blit->bltadat = 0x8000;
+  blit->bltbdat = 0xFFFF;
+  blit->bltafwm = 0xFFFF;
+  blit->bltalwm = 0xFFFF;
+  blit->bltamod = 4 * (dmin - dmax);
+  blit->bltbmod = 4 * dmin;
+  blit->bltcmod = dst_stride_b;
+  blit->bltdmod = dst_stride_b;
+  blit->bltapt = (APTR)(ULONG)((4 * dmin) - (2 * dmax));
+  blit->bltcpt = (APTR)dst_start;
+  blit->bltdpt = (APTR)dst_start;
+  blit->bltsize = ((dmax + 1) << BLTSIZE_H0_SHF) | (0x2 << BLTSIZE_W0_SHF);
+  queue_blit();
 }
 
-void blit_fill(APTR dst_base,
-               UWORD dst_stride_b,
-               UWORD x,
-               UWORD y,
-               UWORD width,
-               UWORD height) {
-  UWORD start_x_word = x / 0x10;
-  UWORD end_x_word = (x + width) / 0x10;
-  UWORD width_words = end_x_word - start_x_word;
-  UWORD word_offset = x & 0xF;
-  UWORD mod_b = dst_stride_b - (width_words * kBytesPerWord);
+void blit_text_line(APTR line_base,
+                    UWORD line_stride_b,
+                    UWORD width_words,
+                    APTR dst_base,
+                    UWORD color,
+                    BOOL replace_bg) {
+  // Line is a row of glyph cell masks followed by kFontHeight rows of glyphs,
+  // already composed at the destination's pixel phase.
+  ULONG src_start = (ULONG)line_base + line_stride_b;
+  ULONG dst_start = (ULONG)dst_base;
 
-  ULONG dst_start_b = (ULONG)dst_base +
-    ((y + height - 1) * dst_stride_b) +
-    ((start_x_word + width_words - 1) * kBytesPerWord);
+  UWORD minterm = replace_bg ? 0xCA : 0xEA;
 
-  UWORD left_word_mask = (UWORD)(0xFFFFU << (word_offset + MAX(0, 0x10 - (word_offset + width)))) >> word_offset;
-  UWORD right_word_mask;
+  for (UWORD plane_idx = 0; plane_idx < kDispDepth; ++ plane_idx) {
+    if (color & (1 << plane_idx)) {
+      Blit* blit = next_blit();
+
+      // A = Glyph cell mask, the same row repeated by a negative modulo
+      // B = Glyph data
+      // C = Destination data (for region outside mask)
+      // D = Destination data
+      blit->bltcon0 = BLTCON0_USEA | BLTCON0_USEB | BLTCON0_USEC | BLTCON0_USED | minterm;
+      blit->bltcon1 = 0;
+      blit->bltamod = -(width_words << 1);
+      blit->bltbmod = line_stride_b - (width_words << 1);
+      blit->bltcmod = kDispStride - (width_words << 1);
+      blit->bltdmod = kDispStride - (width_words << 1);
+      blit->bltafwm = 0xFFFF;
+      blit->bltalwm = 0xFFFF;
+      blit->bltapt = line_base;
+      blit->bltbpt = (APTR)src_start;
+      blit->bltcpt = (APTR)dst_start;
+      blit->bltdpt = (APTR)dst_start;
+      blit->bltsize = (kFontHeight << BLTSIZE_H0_SHF) | width_words;
+      queue_blit();
+    }
 
-  if (width_words == 1) {
-    right_word_mask = left_word_mask;
-  }
-  else {
-    right_word_mask = 0xFFFFU << MIN(0x10, ((start_x_word + width_words) << 4) - (x + width));
+    dst_start += kDispSlice;
   }
+}
 
+void blit_set_async(BOOL async) {
+  // Queued blits are started by blit_int, which must be installed first.
+  blit_fence();
+  g.async = async;
+}
+
+void blit_fence() {
+  while (g.head != g.tail);
   gfx_wait_blit();
+}
 
-  // A = Mask of bits inside copy region
-  // B = Source data
-  // C = Destination data (for region outside mask)
-  // D = Destination data
-  custom.bltcon0 = BLTCON0_USEA | BLTCON0_USED | 0xF0;
-  custom.bltcon1 = BLTCON1_IFE | BLTCON1_DESC;
-  custom.bltamod = mod_b;
-  custom.bltdmod = mod_b;
-  custom.bltafwm = right_word_mask;
-  custom.bltalwm = left_word_mask;
-  custom.bltapt = (APTR)dst_start_b;
-  custom.bltdpt = (APTR)dst_start_b;
-  custom.bltsize = (height << BLTSIZE_H0_SHF) | width_words;
+void blit_int() {
+  // Repeat twice to work around A4000 040/060 bug.
+  custom.intreq = INTREQ_BLIT;
+  custom.intreq = INTREQ_BLIT;
+
+  // The blit at the head has finished, start the one behind it.
+  if (g.head != g.tail) {
+    g.head = (g.head + 1) & (kBlitQueueSize - 1);
+
+    if (g.head != g.tail) {
+      start_blit(&g.queue[g.head]);
+    }
+  }
 }
 
-void blit_char(APTR font_base,
-               UWORD glyph_idx,
-               APTR dst_row_base,
-               UWORD dst_x,
-               UWORD color,
-               BOOL replace_bg) {
-  UWORD start_x_word = dst_x >> 4;
-  UWORD end_x_word = ((dst_x + kFontWidth) + 0xF) >> 4;
-  UWORD width_words = end_x_word - start_x_word;
+static Blit* next_blit() {
+  // Wait for a free entry, one is always kept empty to tell full from empty.
+  while (((g.tail + 1) & (kBlitQueueSize - 1)) == g.head);
 
-  ULONG src_start = (ULONG)font_base + (glyph_idx << 1);
-  ULONG dst_start = (ULONG)dst_row_base + (start_x_word << 1);
-  UWORD shift = dst_x & 0xF;
-  UWORD right_word_mask = (width_words == 1 ? 0xF800 : 0);
+  return &g.queue[g.tail];
+}
 
-  UWORD minterm = replace_bg ? 0xCA : 0xEA;
+static void queue_blit() {
+  Blit* blit = &g.queue[g.tail];
 
-  for (UWORD plane_idx = 0; plane_idx < kDispDepth; ++ plane_idx) {
-    if (color & (1 << plane_idx)) {
-      gfx_wait_blit();
-
-      custom.bltcon0 = (shift << BLTCON0_ASH0_SHF) | BLTCON0_USEB | BLTCON0_USEC | BLTCON0_USED | minterm;
-      custom.bltcon1 = shift << BLTCON1_BSH0_SHF;
-      custom.bltbmod = (kFontNGlyphs * kBytesPerWord) - (width_words << 1);
-      custom.bltcmod = kDispStride - (width_words << 1);
-      custom.bltdmod = kDispStride - (width_words << 1);
-      custom.bltafwm = 0xF800;
-      custom.bltalwm = right_word_mask;
-      custom.bltadat = 0xFFFF;
-      custom.bltbpt = (APTR)src_start;
-      custom.bltcpt = (APTR)dst_start;
-      custom.bltdpt = (APTR)dst_start;
-      custom.bltsize = (kFontHeight << BLTSIZE_H0_SHF) | width_words;
-    }
+  if (! g.async) {
+    gfx_wait_blit();
+    start_blit(blit);
+    return;
+  }
 
-    dst_start += kDispSlice;
+  // Keep blit_int from advancing the head while this entry is published.
+  custom.intena = INTENA_BLIT;
+
+  BOOL idle = (g.head == g.tail);
+  g.tail = (g.tail + 1) & (kBlitQueueSize - 1);
+
+  if (idle) {
+    start_blit(blit);
   }
+
+  custom.intena = INTENA_SET | INTENA_BLIT;
+}
+
+static void start_blit(Blit* blit) {
+  custom.bltcon0 = blit->bltcon0;
+  custom.bltcon1 = blit->bltcon1;
+  custom.bltafwm = blit->bltafwm;
+  custom.bltalwm = blit->bltalwm;
+  custom.bltamod = blit->bltamod;
+  custom.bltbmod = blit->bltbmod;
+  custom.bltcmod = blit->bltcmod;
+  custom.bltdmod = blit->bltdmod;
+  custom.bltadat = blit->bltadat;
+  custom.bltbdat = blit->bltbdat;
+  custom.bltapt = blit->bltapt;
+  custom.bltbpt = blit->bltbpt;
+  custom.bltcpt = blit->bltcpt;
+  custom.bltdpt = blit->bltdpt;
+  custom.bltsize = blit->bltsize;
 }
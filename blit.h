@@ -2,6 +2,12 @@
 
 #include "common.h"
 
+// Blits are queued while async, each started by the previous one's interrupt.
+// Call blit_fence before the CPU touches memory a queued blit reads or writes.
+void blit_set_async(BOOL async);
+void blit_fence();
+void blit_int();
+
 void blit_copy(APTR src_base,
                UWORD src_stride_b,
                UWORD src_x,
@@ -34,16 +40,9 @@ void blit_line(APTR dst_base,
                UWORD x1,
                UWORD y1);
 
-void blit_fill(APTR dst_base,
-               UWORD dst_stride_b,
-               UWORD x,
-               UWORD y,
-               UWORD width,
-               UWORD height);
-
-void blit_char(APTR font_base,
-               UWORD glyph_idx,
-               APTR dst_row_base,
-               UWORD dst_x,
-               UWORD color,
-               BOOL replace_bg);
+void blit_text_line(APTR line_base,
+                    UWORD line_stride_b,
+                    UWORD width_words,
+                    APTR dst_base,
+                    UWORD color,
+                    BOOL replace_bg);
@@ -0,0 +1,153 @@
+#include "calib.h"
+#include "custom.h"
+#include "ptplayer/ptplayer.h"
+#include "system.h"
+
+#include <proto/dos.h>
+
+#define PREFS_ID(a, b, c, d) (((a) << 0x18) | ((b) << 0x10) | ((c) << 0x8) | (d))
+
+#define kPrefsPath "S:ModSurfer.prefs"
+#define kPrefsID PREFS_ID('M', 'S', 'P', '1')
+#define kClickIntervalPeriods 30 // Timer A periods, 0.6s at the default tempo
+#define kClickPeriod 428
+#define kClickVolume 0x40
+#define kNumLeadInClicks 4
+#define kNumTaps 8
+#define kMaxClicks (kNumLeadInClicks + (kNumTaps * 2))
+#define kMaxLatencyMillis 500
+
+typedef struct {
+  ULONG id;
+  ULONG latency_ticks;
+} Prefs;
+
+static BOOL tap_pressed();
+
+// Short decaying 2kHz burst at the click period.
+static BYTE click_sample[0x20] __chip = {
+   127,  127, -127, -127,  112,  112, -112, -112,
+    96,   96,  -96,  -96,   80,   80,  -80,  -80,
+    64,   64,  -64,  -64,   48,   48,  -48,  -48,
+    32,   32,  -32,  -32,   16,   16,  -16,  -16,
+};
+
+static struct {
+  ULONG latency_ticks;
+} g;
+
+void calib_init() {
+  BPTR file = 0;
+  Prefs prefs = {0};
+
+  // Missing or unreadable preferences leave latency at zero.
+  if ((file = Open(kPrefsPath, MODE_OLDFILE))) {
+    if ((Read(file, &prefs, sizeof(prefs)) == sizeof(prefs)) && (prefs.id == kPrefsID)) {
+      g.latency_ticks = MIN(prefs.latency_ticks, (ULONG)kMaxLatencyMillis * system_ticks_per_milli());
+    }
+
+    Close(file);
+  }
+}
+
+Status calib_run() {
+  Status status = StatusOK;
+
+  SfxStructure click = {
+    .sfx_ptr = click_sample,
+    .sfx_len = sizeof(click_sample) / kBytesPerWord,
+    .sfx_per = kClickPeriod,
+    .sfx_vol = kClickVolume,
+    .sfx_cha = -1,
+    .sfx_pri = 1,
+  };
+
+  system_acquire_control();
+
+  ULONG interval = (ULONG)kClickIntervalPeriods * ms_TimerPeriod;
+  ULONG last_click = 0;
+  ULONG next_click = system_tick_clock() + interval;
+  UWORD num_clicks = 0;
+  UWORD num_taps = 0;
+  LONG offset_sum = 0;
+
+  // A button held from the menu is not a tap.
+  BOOL was_pressed = tap_pressed();
+
+  while ((num_taps < kNumTaps) && (num_clicks < kMaxClicks)) {
+    CHECK(! keyboard_state[kKeycodeEsc], StatusAborted);
+
+    ULONG now = system_tick_clock();
+
+    if ((LONG)(now - next_click) >= 0) {
+      mt_playfx(&custom, &click);
+
+      last_click = next_click;
+      next_click += interval;
+      ++ num_clicks;
+    }
+
+    // Poll continuously rather than per frame for sub-frame tap timing.
+    BOOL pressed = tap_pressed();
+
+    if (pressed && (! was_pressed) && (num_clicks > kNumLeadInClicks)) {
+      // Offset from the nearest click, early taps belong to the next one.
+      LONG offset = now - last_click;
+
+      if (offset > (LONG)(interval / 2)) {
+        offset -= interval;
+      }
+
+      offset_sum += offset;
+      ++ num_taps;
+    }
+
+    was_pressed = pressed;
+  }
+
+  CHECK(num_taps == kNumTaps, StatusAborted);
+
+  // Early taps on average mean no measurable latency.
+  LONG latency = offset_sum / (WORD)kNumTaps;
+  g.latency_ticks = MIN(MAX(0, latency), (LONG)kMaxLatencyMillis * system_ticks_per_milli());
+
+cleanup:
+  system_release_control();
+
+  return status;
+}
+
+static BOOL tap_pressed() {
+  // Space, left mouse button or joystick fire, buttons are active low.
+  return keyboard_state[kKeycodeSpace] ||
+    ((ciaa.ciapra & (CIAF_GAMEPORT0 | CIAF_GAMEPORT1)) != (CIAF_GAMEPORT0 | CIAF_GAMEPORT1));
+}
+
+Status calib_save() {
+  Status status = StatusOK;
+  BPTR file = 0;
+
+  Prefs prefs = {
+    .id = kPrefsID,
+    .latency_ticks = g.latency_ticks,
+  };
+
+  // Boot disk may be write protected, fail quietly.
+  CHECK(file = Open(kPrefsPath, MODE_NEWFILE), StatusError);
+  CHECK(Write(file, &prefs, sizeof(prefs)) == sizeof(prefs), StatusError);
+
+cleanup:
+  if (file) {
+    Close(file);
+  }
+
+  return status;
+}
+
+ULONG calib_latency_ticks() {
+  return g.latency_ticks;
+}
+
+UWORD calib_latency_millis() {
+  return g.latency_ticks / system_ticks_per_milli();
+}
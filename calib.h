@@ -0,0 +1,9 @@
+#pragma once
+
+#include "common.h"
+
+extern void calib_init();
+extern Status calib_run();   // StatusError, StatusAborted
+extern Status calib_save();  // StatusError
+extern ULONG calib_latency_ticks();
+extern UWORD calib_latency_millis();
@@ -115,6 +115,44 @@ void string_append_path(STRPTR base,
   }
 }
 
+void string_from_uword(STRPTR dst,
+                       UWORD value) {
+  BYTE digits[5];
+  UWORD num_digits = 0;
+
+  // Collect decimal digits least significant first, at least one.
+  do {
+    digits[num_digits ++] = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+
+  while (num_digits) {
+    *(dst ++) = digits[-- num_digits];
+  }
+
+  *dst = '\0';
+}
+
+void string_from_ulong(STRPTR dst,
+                       ULONG value) {
+  // Print the high part first, any remainder below 10000 zero padded.
+  if (value <= kUWordMax) {
+    string_from_uword(dst, value);
+    return;
+  }
+
+  string_from_ulong(dst, value / 10000);
+  dst += string_length(dst);
+
+  UWORD low = value % 10000;
+
+  for (UWORD divisor = 1000; divisor; divisor /= 10) {
+    *(dst ++) = '0' + ((low / divisor) % 10);
+  }
+
+  *dst = '\0';
+}
+
 void print_error(STRPTR str) {
   system_print_error(str);
 }
@@ -48,6 +48,7 @@ typedef enum {
   StatusInvalidMod  = (1 << 3),
   StatusQuit        = (1 << 4),
   StatusPlay        = (1 << 5),
+  StatusAborted     = (1 << 6),
 } Status;
 
 extern Status common_init();  // StatusError
@@ -65,5 +66,9 @@ extern BOOL string_has_prefix(STRPTR name,
                               UWORD prefix_len);
 extern void string_append_path(STRPTR base,
                                STRPTR subdir);
+extern void string_from_uword(STRPTR dst,
+                              UWORD value);
+extern void string_from_ulong(STRPTR dst,
+                              ULONG value);
 extern void print_error(STRPTR str);
 extern UWORD random_mod4();
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <hardware/cia.h>
 #include <hardware/custom.h>
 
 extern volatile struct Custom custom;
+extern volatile struct CIA ciaa;
+extern volatile struct CIA ciab;
 
 #define CUSTOM_OFFSET(X) offsetof(struct Custom, X)
 
@@ -30,6 +33,7 @@ extern volatile struct Custom custom;
 #define DIWHIGH_V8_SHF   0x8
 #define DIWSTOP_V0_SHF   0x8
 #define DIWSTRT_V0_SHF   0x8
+#define FMODE_BPL32      0x0001
 #define DMACON_SET       0x8000
 #define DMACON_CLEARALL  0x7FFF
 #define DMACON_BLITPRI   0x0400
@@ -42,8 +46,14 @@ extern volatile struct Custom custom;
 #define INTENA_SET       0x8000
 #define INTENA_CLEARALL  0x7FFF
 #define INTENA_PORTS     0x0008
+#define INTENA_COPER     0x0010
+#define INTENA_VERTB     0x0020
+#define INTENA_BLIT      0x0040
 #define INTREQ_SET       0x8000
 #define INTREQ_CLEARALL  0x7FFF
+#define INTREQ_COPER     0x0010
+#define INTREQ_VERTB     0x0020
+#define INTREQ_BLIT      0x0040
 #define JOYxDAT_XALL     0x00FF
 #define JOYxDAT_Y1       0x0200
 #define JOYxDAT_X1       0x0002
@@ -1,8 +1,10 @@
 #include "game.h"
 #include "custom.h"
+#include "calib.h"
 #include "gfx.h"
 #include "menu.h"
 #include "module.h"
+#include "profile.h"
 #include "ptplayer/ptplayer.h"
 #include "system.h"
 #include "track.h"
@@ -11,33 +13,79 @@
 #define kNumTimeoutFrames 200
 #define kVUMeterZDecay 0x1000
 #define kVolumeMax 0x40
-#define kNoSuppressSample 0xFF // Any unused sample number
+#define kNumChannels 4
 #define kBallDXMax 90 // Larger number = sharper movement
+#define kInputLatchMouse 0x100 // Mouse mode flag in g.input_latch
+#define kDefaultTicksPerRow 6
 
 static void game_play_loop();
 static void ptplayer_start();
 static void ptplayer_stop();
 static void handle_steps();
+static void set_row_timing(RowEvent* event);
+static void handle_camera();
+static void set_latency();
 static void handle_input();
 static UBYTE read_mouse_x();
 static BYTE read_joy_dx();
+static WORD late_ball_x();
 static void handle_collision();
 static void handle_fade();
 static void handle_gfx();
 static void handle_timeout();
+static void handle_pause();
+static void pause_game();
+static void resume_game();
+static void record_row_sync();
+static void handle_sync_overlay();
+static void print_sync_summary();
+static STRPTR format_row_percent(STRPTR text, LONG z, UWORD max_digits);
+static STRPTR format_clamped(STRPTR text, LONG value, UWORD max_digits);
+#ifdef MS_PROFILE
+static void print_replay_profile();
+#endif
 
 static struct {
   TrackStep* steps;
   UWORD next_step_idx;
   UWORD end_step_idx;
+  UWORD start_pos;
+  UWORD start_step_idx;
   UWORD num_blocks_total;
   UWORD num_blocks_left;
   ULONG camera_z;
   UWORD camera_z_inc;
+  UBYTE row_tail;
+  ULONG row_time;
+  ULONG row_z;
+  UWORD row_units;
+  UWORD row_unit_shift;
+  UWORD z_per_unit;
+  UWORD rows_dropped;
+  UWORD lead_rows;
+  ULONG latency_ticks;
+  UWORD latency_z;
+  ULONG view_z;
+  UWORD view_step_idx;
+  UWORD suppress_step_idx[kNumChannels]; // Block whose sample is armed, 0 if none
+  UWORD mute_step_idx[kNumChannels]; // Block whose note played at zero volume
+  BOOL paused;
+  BOOL pause_key_down;
+  ULONG event_shift_ticks; // Pause length, added to events pushed before it
+  UBYTE event_shift_count; // ^- number of such events not yet handled
+  UWORD sync_rows;
+  UWORD sync_max_backlog; // Most row events handled in one frame
+  LONG sync_snap; // Camera correction at the last row, Z
+  LONG sync_max_snap; // ^- largest magnitude
+  LONG sync_drift; // ^- sum over the song
+  BOOL sync_overlay;
+  BOOL sync_overlay_dirty;
+  BOOL help_key_down;
   UWORD vu_meter_view_z;
   WORD ball_x;
   BYTE ball_dx_smoothed[(2 * kBallDXMax) + 1];
   UBYTE prev_mouse_x;
+  ULONG input_latch; // Ball X (high), mouse mode and X (low), one write for the interrupt
   UWORD score;
   UWORD fade_frames;
   UWORD timeout_frames;
@@ -73,21 +121,33 @@ Status game_main_loop() {
     }
 
     // Attempt to load the module and build the track. Either may fail.
+    // The track is kept until another module is selected in the menu.
     CATCH(module_load_all(), StatusInvalidMod | StatusOutOfMemory);
 
-    if (status == StatusOK) {
+    if ((status == StatusOK) && (! track_is_built())) {
       CATCH(track_build(), StatusOutOfMemory);
     }
 
     system_acquire_blitter();
 
     if (status == StatusOK) {
+      // Lanes for every difficulty tier were built together, pick one.
+      // Practice may start part way through, hiding blocks before the start.
+      // Detail defaults to the CPU's profile unless changed in the menu.
+      gfx_select_detail(menu_detail());
+      track_select_tier(menu_track_tier());
+      g.start_pos = track_start_pos(menu_start_pos());
+      g.start_step_idx = track_select_start(g.start_pos, gfx_num_visible_steps());
+
       // Exit the menu and start the game.
       gfx_fade_menu(FALSE);
       gfx_setup_copperlist(FALSE);
       game_play_loop();
 
-      track_free();
+#ifdef MS_PROFILE
+      print_replay_profile();
+      profile_print();
+#endif
     }
     else {
       // Stay on menu and report the error.
@@ -106,20 +166,40 @@ cleanup:
 
 static void game_play_loop() {
   // Reset game state.
-  g.steps = track_steps();
+  g.steps = track_steps() + g.start_step_idx;
   g.next_step_idx = 0;
-  g.end_step_idx = track_unpadded_length() - 1;
+  g.end_step_idx = track_unpadded_length() - g.start_step_idx - 1;
   g.num_blocks_total = track_num_blocks();
   g.num_blocks_left = g.num_blocks_total;
   g.camera_z = 0;
   g.camera_z_inc = 0;
+  g.row_time = 0;
+  g.row_z = 0;
+  g.row_units = 0;
+  g.latency_z = 0;
+  g.view_z = 0;
+  g.view_step_idx = 0;
+  g.rows_dropped = 0;
   g.vu_meter_view_z = 0;
   g.ball_x = 0;
   g.prev_mouse_x = read_mouse_x();
+  g.input_latch = 0;
   g.score = 0;
   g.fade_frames = kNumFadeFrames;
   g.timeout_frames = kNumTimeoutFrames;
   g.running = TRUE;
+  g.paused = FALSE;
+  g.pause_key_down = TRUE; // Wait for a fresh press
+  g.event_shift_count = 0;
+  g.sync_rows = 0;
+  g.sync_max_backlog = 0;
+  g.sync_snap = 0;
+  g.sync_max_snap = 0;
+  g.sync_drift = 0;
+  g.sync_overlay_dirty = TRUE;
+  g.help_key_down = TRUE; // Wait for a fresh press
+
+  PROFILE_RESET();
 
   // All colors faded to zero by this point.
   system_acquire_control();
@@ -129,20 +209,45 @@ static void game_play_loop() {
   gfx_wait_blit();
   gfx_allow_copper_blits(TRUE);
 
+  // Reposition the ball from fresh input each frame, just before it is shown.
+  gfx_set_ball_latch(late_ball_x);
+
   ptplayer_start();
 
   while (g.running || g.fade_frames) {
     gfx_wait_vblank();
 
+    handle_pause();
+
+    if (g.paused) {
+      continue;
+    }
+
+    PROFILE_PHASE(ProfilePhaseSteps);
     handle_steps();
+    PROFILE_PHASE(ProfilePhaseCamera);
+    handle_camera();
+    PROFILE_PHASE(ProfilePhaseInput);
     handle_input();
+    PROFILE_PHASE(ProfilePhaseCollision);
     handle_collision();
+    PROFILE_PHASE(ProfilePhaseFade);
     handle_fade();
+    PROFILE_PHASE(ProfilePhaseGfx);
     handle_gfx();
+    PROFILE_PHASE(ProfilePhaseOther);
+    handle_sync_overlay();
     handle_timeout();
+    PROFILE_END_FRAME();
   }
 
   ptplayer_stop();
+  gfx_set_ball_latch(NULL);
+
+  // Header is shared with the menu, remove the overlay.
+  if (g.sync_overlay) {
+    gfx_draw_debug_text("");
+  }
 
   // Disable copper blits before using the blitter.
   gfx_allow_copper_blits(FALSE);
@@ -151,52 +256,118 @@ static void game_play_loop() {
   // All colors faded to zero by this point.
   gfx_clear_body();
   system_release_control();
+
+  print_sync_summary();
 }
 
 static void ptplayer_start() {
-  mt_init(&custom, module_nonchip(), module_samples(), 0);
+  mt_init(&custom, module_nonchip(), module_samples(), g.start_pos);
   mt_mastervol(&custom, kVolumeMax);
 
+  // Row events from a previous game are stale, start reading from the head.
+  g.row_tail = ms_RowHead;
+
   // Delay ptplayer until first module row crosses all visible steps.
   // Offset slightly earlier to account for the player's Z position.
-  ms_HoldRows = kNumVisibleSteps - kNumStepsDelay;
+  // Start earlier still by whole rows of calibrated audio latency.
+  set_latency();
+  ms_HoldRows = gfx_num_visible_steps() - kNumStepsDelay - g.lead_rows;
+
+  // mt_init disarmed suppression on all channels.
+  for (UWORD i = 0; i < kNumChannels; ++ i) {
+    g.suppress_step_idx[i] = 0;
+    g.mute_step_idx[i] = 0;
+  }
 
-  ms_SuppressSample = kNoSuppressSample;
   mt_Enable = 1;
 }
 
+static void set_latency() {
+  // Split latency into whole rows at the default tempo, played early by ptplayer,
+  // and a remainder by which the view lags the camera.
+  ULONG latency = calib_latency_ticks();
+  ULONG row_ticks = (ULONG)kDefaultTicksPerRow * ms_TimerPeriod;
+
+  g.lead_rows = MIN(latency / row_ticks, gfx_num_visible_steps() - kNumStepsDelay);
+  g.latency_ticks = MIN(latency - (g.lead_rows * row_ticks), row_ticks - 1);
+}
+
 static void ptplayer_stop() {
   mt_Enable = 0;
   mt_end(&custom);
 }
 
 static void handle_steps() {
+  // A backlog of more than one row means the game loop fell behind ptplayer.
+  g.sync_max_backlog = MAX(g.sync_max_backlog, (UBYTE)(ms_RowHead - g.row_tail));
+
   // If ptplayer has asynchronously advanced one or more steps then process them.
-  while (ms_StepCount > 0) {
-    TrackStep* play_step = &g.steps[g.next_step_idx + kNumStepsDelay];
+  // Events are read without locking, ptplayer publishes the head after writing.
+  while (g.row_tail != ms_RowHead) {
+    RowEvent event = ms_RowEvents[g.row_tail & (kNumRowEvents - 1)];
+
+    // Rows pushed before a pause are timed as if they followed it.
+    if (g.event_shift_count) {
+      event.time += g.event_shift_ticks;
+      -- g.event_shift_count;
+    }
+
+    // Event may have been overwritten before or during the copy if we fell a
+    // whole ring behind. The row was still played, so only its timing is lost.
+    BOOL dropped = ((UBYTE)(ms_RowHead - g.row_tail) >= kNumRowEvents);
+
+    UWORD play_step_idx = g.next_step_idx + kNumStepsDelay + g.lead_rows;
+    TrackStep* play_step = &g.steps[play_step_idx];
 
     if (play_step->active_lane) {
       -- g.num_blocks_left;
     }
 
-    // Suppress the sample corresponding to the next block.
+    // The step's note has played, muted if its block wasn't hit in time.
+    // Disarm its channel so later notes of the sample play normally.
+    UWORD play_channel = track_step_channel(play_step);
+
+    if (g.suppress_step_idx[play_channel] == play_step_idx) {
+      ms_suppress(&custom, play_channel, 0);
+      g.suppress_step_idx[play_channel] = 0;
+      g.mute_step_idx[play_channel] = play_step_idx;
+    }
+
+    // Suppress the sample corresponding to the next block, on its channel only.
     // This will reset if the block is touched or the next step is reached.
-    UBYTE next_sample = (play_step + 1)->sample;
+    // Steps keep their sample in tiers where they have no block, skip those.
+    UWORD next_step_idx = play_step_idx + 1;
+    TrackStep* next_step = &g.steps[next_step_idx];
+
+    if (next_step->active_lane && next_step->sample) {
+      UWORD channel = track_step_channel(next_step);
+      ms_suppress(&custom, channel, next_step->sample);
+      g.suppress_step_idx[channel] = next_step_idx;
+    }
 
-    if (next_sample) {
-      ms_SuppressSample = next_sample;
+    // Recalculate per-frame Z increment to match the row's speed and tempo.
+    // Synchronize Z position with ptplayer at the start of the row.
+    if (dropped) {
+      // Assume the row followed the previous one at the same speed.
+      g.row_time += (ULONG)g.row_units << g.row_unit_shift;
+      ++ g.rows_dropped;
+    }
+    else {
+      g.row_time = event.time;
+      set_row_timing(&event);
     }
 
-    // Recalculate per-frame Z increment to match step speed.
-    // Synchronize Z position with ptplayer.
-    g.camera_z_inc = ms_camera_z_inc(kBlockGapDepth);
-    g.camera_z = g.next_step_idx * kBlockGapDepth;
+    g.row_z = g.next_step_idx * gfx_block_gap_depth();
+
+    if (! dropped) {
+      record_row_sync();
+    }
 
     ++ g.next_step_idx;
-    -- ms_StepCount;
+    ++ g.row_tail;
 
     // After last step stop ptplayer (to prevent looping) and begin fade out.
-    if (g.next_step_idx == g.end_step_idx) {
+    if ((g.next_step_idx + g.lead_rows) == g.end_step_idx) {
       mt_Enable = 0;
       g.fade_frames = kNumFadeFrames;
       g.running = FALSE;
@@ -204,6 +375,61 @@ static void handle_steps() {
   }
 }
 
+static void set_row_timing(RowEvent* event) {
+  // Normalize row duration in CIA ticks to 15 bits.
+  // Per-frame interpolation is then a single 16x16 multiply.
+  ULONG row_ticks = event->ticks;
+  UWORD shift = 0;
+
+  while (row_ticks >= 0x8000) {
+    row_ticks >>= 1;
+    ++ shift;
+  }
+
+  g.row_units = row_ticks;
+  g.row_unit_shift = shift;
+  g.z_per_unit = row_ticks ? (((ULONG)gfx_block_gap_depth() << 16) / row_ticks) : 0;
+
+  // Per-frame Z increment from the measured frame period, 50Hz or 60Hz.
+  UWORD frame_units = MIN(system_frame_ticks() >> shift, row_ticks);
+  g.camera_z_inc = ((ULONG)frame_units * g.z_per_unit) >> 16;
+
+  // Latency remainder as Z at this row's speed, kept within one row.
+  UWORD latency_units = MIN(g.latency_ticks >> shift, row_ticks);
+  g.latency_z = MIN(((ULONG)latency_units * g.z_per_unit) >> 16, gfx_block_gap_depth() - 1);
+}
+
+static void handle_camera() {
+  // No timing until ptplayer has started the first row.
+  if (g.row_units != 0) {
+    // Position within the current row from the CIA tick clock, phase locked to ptplayer.
+    ULONG elapsed_units = (system_tick_clock() - g.row_time) >> g.row_unit_shift;
+
+    if (elapsed_units < g.row_units) {
+      ULONG camera_z = g.row_z + (((ULONG)(UWORD)elapsed_units * g.z_per_unit) >> 16);
+
+      // Never step backwards, e.g. while a timer underflow is not yet serviced.
+      g.camera_z = MAX(g.camera_z, camera_z);
+    }
+    else if (! g.running) {
+      // ptplayer stopped at the end of the track, keep moving while fading out.
+      g.camera_z += g.camera_z_inc;
+    }
+    else {
+      // Next row is due, hold at the end of this one until its event arrives.
+      g.camera_z = MAX(g.camera_z, g.row_z + gfx_block_gap_depth() - 1);
+    }
+  }
+
+  // View lags the camera by the latency remainder, possibly into the previous row.
+  g.view_z = (g.camera_z > g.latency_z) ? (g.camera_z - g.latency_z) : 0;
+  g.view_step_idx = g.next_step_idx;
+
+  if ((g.view_z < g.row_z) && (g.view_step_idx > 0)) {
+    -- g.view_step_idx;
+  }
+}
+
 static void handle_input() {
   static BOOL mouse_active = TRUE;
 
@@ -251,6 +477,9 @@ static void handle_input() {
   // Clamp ball X position to within bounds.
   g.ball_x = MAX(-kLaneWidth, MIN(kLaneWidth, g.ball_x));
 
+  // Publish input for late_ball_x in a single write.
+  g.input_latch = ((ULONG)(UWORD)g.ball_x << 0x10) | (mouse_active ? kInputLatchMouse : 0) | g.prev_mouse_x;
+
   // Begin fade out if the escape key is pressed.
   if (g.running && keyboard_state[kKeycodeEsc]) {
     g.fade_frames = kNumFadeFrames;
@@ -262,13 +491,29 @@ static UBYTE read_mouse_x() {
   return custom.joy0dat & JOYxDAT_XALL;
 }
 
+// Called from the copper interrupt ahead of the ball's first scanline.
+// Mouse movement since handle_input moves the ball sprite now, and is
+// applied to the game state by the next handle_input as usual.
+static WORD late_ball_x() {
+  ULONG latch = g.input_latch;
+  WORD ball_x = latch >> 0x10;
+
+  if ((latch & kInputLatchMouse) && (! g.paused)) {
+    BYTE mouse_dx = read_mouse_x() - (UBYTE)latch;
+    ball_x = MAX(-kLaneWidth, MIN(kLaneWidth, ball_x + mouse_dx));
+  }
+
+  return ball_x;
+}
+
 static BYTE read_joy_dx() {
   UWORD joy1dat = custom.joy1dat;
   return (joy1dat & JOYxDAT_Y1) ? -1 : ((joy1dat & JOYxDAT_X1) ? 1 : 0);
 }
 
 static void handle_collision() {
-  TrackStep* ball_step = &g.steps[g.next_step_idx + kNumStepsDelay];
+  UWORD ball_step_idx = g.view_step_idx + kNumStepsDelay;
+  TrackStep* ball_step = &g.steps[ball_step_idx];
 
   // Check for a block which has not been hit in this row.
   if (ball_step->active_lane && (ball_step->color < kNumBlockColors)) {
@@ -289,8 +534,18 @@ static void handle_collision() {
       // Make block darker now that it's been hit.
       ball_step->color += kNumBlockColors;
 
-      // Don't suppress the sample associated with the block.
-      ms_SuppressSample = kNoSuppressSample;
+      // Don't suppress the sample associated with the block. If its note
+      // already played at zero volume, hit within latency, restore it.
+      UWORD channel = track_step_channel(ball_step);
+
+      if (g.suppress_step_idx[channel] == ball_step_idx) {
+        ms_suppress(&custom, channel, 0);
+        g.suppress_step_idx[channel] = 0;
+      }
+      else if (g.mute_step_idx[channel] == ball_step_idx) {
+        ms_unmute(&custom, channel);
+        g.mute_step_idx[channel] = 0;
+      }
 
       // VU meter back to maximum.
       g.vu_meter_view_z = kFarZ;
@@ -316,16 +571,162 @@ static void handle_fade() {
 
 static void handle_gfx() {
   // Calculate world Z for VU meter top and apply per-frame decay.
-  ULONG vu_meter_z = g.vu_meter_view_z + g.camera_z;
+  ULONG vu_meter_z = g.vu_meter_view_z + g.view_z;
   g.vu_meter_view_z = MAX(0, g.vu_meter_view_z - kVUMeterZDecay);
 
   // Score is measured as 1/1000ths of total possible.
   UWORD score_frac = (g.score * 1000) / g.num_blocks_total;
 
-  gfx_update_display(&g.steps[g.next_step_idx], g.ball_x, g.camera_z,
+  gfx_update_display(&g.steps[g.view_step_idx], g.ball_x, g.view_z,
                      g.camera_z_inc, vu_meter_z, score_frac);
+}
 
-  g.camera_z += g.camera_z_inc;
+static void handle_pause() {
+  // Toggle pause on each press of P, only while the song is playing.
+  BOOL key_pause = keyboard_state[kKeycodeP];
+
+  if (key_pause && (! g.pause_key_down) && g.running) {
+    if (g.paused) {
+      resume_game();
+    }
+    else {
+      pause_game();
+    }
+  }
+
+  g.pause_key_down = key_pause;
+
+  // Escape still ends a paused game, handled as usual once resumed.
+  if (g.paused && keyboard_state[kKeycodeEsc]) {
+    resume_game();
+  }
+}
+
+static void pause_game() {
+  // Freeze ptplayer with its channels silenced, the game state is left untouched.
+  ms_pause(&custom);
+  g.paused = TRUE;
+}
+
+static void resume_game() {
+  // Tick clock ran on during the pause. Shift the current row and pending events
+  // by the whole timer periods ptplayer skipped, keeping the camera in phase.
+  // No rows are pushed while paused, count pending ones before resuming.
+  g.event_shift_count = (UBYTE)(ms_RowHead - g.row_tail);
+
+  ULONG pause_ticks = ms_resume(&custom, system_tick_clock());
+
+  g.row_time += pause_ticks;
+  g.event_shift_ticks = pause_ticks;
+  g.paused = FALSE;
+}
+
+static void record_row_sync() {
+  // Camera correction is the distance from where it was to where the clock
+  // puts it in the new row, positive when the visuals lagged the audio.
+  ULONG elapsed_units = (system_tick_clock() - g.row_time) >> g.row_unit_shift;
+  UWORD row_units = MIN(elapsed_units, g.row_units);
+  ULONG clock_z = g.row_z + (((ULONG)row_units * g.z_per_unit) >> 16);
+
+  g.sync_snap = (LONG)clock_z - (LONG)g.camera_z;
+  g.sync_max_snap = MAX(g.sync_max_snap, ABS(g.sync_snap));
+  g.sync_drift += g.sync_snap;
+  ++ g.sync_rows;
+
+  g.sync_overlay_dirty = TRUE;
+}
+
+static void handle_sync_overlay() {
+  // Help toggles the overlay, cleared when hidden.
+  BOOL key_help = keyboard_state[kKeycodeHelp];
+
+  if (key_help && (! g.help_key_down)) {
+    g.sync_overlay = ! g.sync_overlay;
+    g.sync_overlay_dirty = TRUE;
+
+    if (! g.sync_overlay) {
+      gfx_draw_debug_text("");
+    }
+  }
+
+  g.help_key_down = key_help;
+
+  // Redraw once per row at most: backlog, dropped rows, last and summed correction.
+  // Fixed widths fit the 15 debug text characters, e.g. "B9D99C-99S-9999".
+  if (g.sync_overlay && g.sync_overlay_dirty) {
+    BYTE text[0x20];
+    STRPTR end = text;
+
+    *(end ++) = 'B';
+    end = format_clamped(end, g.sync_max_backlog, 1);
+    *(end ++) = 'D';
+    end = format_clamped(end, g.rows_dropped, 2);
+    *(end ++) = 'C';
+    end = format_row_percent(end, g.sync_snap, 2);
+    *(end ++) = 'S';
+    format_row_percent(end, g.sync_drift, 4);
+
+    gfx_draw_debug_text(text);
+    g.sync_overlay_dirty = FALSE;
+  }
+}
+
+static void print_sync_summary() {
+  BYTE text[0x80];
+  STRPTR end = text;
+
+  string_copy(end, "sync: rows ");
+  string_from_uword(end + string_length(end), g.sync_rows);
+  end += string_length(end);
+  string_copy(end, ", max backlog ");
+  string_from_uword(end + string_length(end), g.sync_max_backlog);
+  end += string_length(end);
+  string_copy(end, ", dropped ");
+  string_from_uword(end + string_length(end), g.rows_dropped);
+  end += string_length(end);
+  string_copy(end, ", max correction ");
+  end = format_row_percent(end + string_length(end), g.sync_max_snap, 4);
+  string_copy(end, "% row, drift ");
+  end = format_row_percent(end + string_length(end), g.sync_drift, 4);
+  string_copy(end, "% row\n");
+
+  system_print(text);
+}
+
+static STRPTR format_row_percent(STRPTR text,
+                                 LONG z,
+                                 UWORD max_digits) {
+  // Signed Z distance as a percentage of a row, returns the end of the text.
+  return format_clamped(text, (z * 100) / gfx_block_gap_depth(), max_digits);
+}
+
+static STRPTR format_clamped(STRPTR text,
+                             LONG value,
+                             UWORD max_digits) {
+  // Signed value in at most max_digits digits, all '*' if it does not fit.
+  // Returns the end of the text.
+  LONG limit = 1;
+
+  for (UWORD i = 0; i < max_digits; ++ i) {
+    limit *= 10;
+  }
+
+  if (value < 0) {
+    *(text ++) = '-';
+    value = -value;
+  }
+
+  if (value >= limit) {
+    for (UWORD i = 0; i < max_digits; ++ i) {
+      *(text ++) = '*';
+    }
+
+    *text = '\0';
+    return text;
+  }
+
+  string_from_uword(text, value);
+  return text + string_length(text);
 }
 
 static void handle_timeout() {
@@ -341,3 +742,31 @@ static void handle_timeout() {
     g.fade_frames = kNumFadeFrames;
   }
 }
+
+#ifdef MS_PROFILE
+static void print_replay_profile() {
+  // Histogram of color clocks spent in ptplayer's interrupt per replay tick.
+  BYTE line[0x20];
+
+  system_print("replay profile, color clocks: max ");
+  string_from_ulong(line, ms_ProfMax);
+  system_print(line);
+  system_print("\n");
+
+  for (UWORD i = 0; i < kNumProfBuckets; ++ i) {
+    if (ms_ProfHist[i] != 0) {
+      STRPTR text = line;
+
+      string_from_uword(text, i << 8);
+      text += string_length(text);
+      string_copy(text, "+: ");
+      text += string_length(text);
+      string_from_uword(text, ms_ProfHist[i]);
+      text += string_length(text);
+      string_copy(text, "\n");
+
+      system_print(line);
+    }
+  }
+}
+#endif
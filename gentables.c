@@ -3,6 +3,13 @@
 
 #define kFFTSizeLog2 9
 #define kFFTSize (1 << (kFFTSizeLog2))
+#define kNumFinetunes 16
+#define kNumNotes 36
+#define kNumBlockColors 12 // Must match track.h
+#define kPeriodC1 856
+#define kPeriodTableSize 908 // C-1 with finetune -8 = 907
+#define kMaxTicksPerDiv 0x20
+#define kEnvelopeDecayPerTick 0.8
 
 int main() {
   printf("#include <exec/types.h>\n\n");
@@ -49,5 +56,68 @@ int main() {
     printf(" 0x%03hX,", (unsigned short)reorder);
   }
 
+  printf("\n};\n\n");
+
+  printf("#define kNumFinetunes %d\n", kNumFinetunes);
+  printf("#define kNumNotes %d\n", kNumNotes);
+  printf("#define kPeriodTableSize %d\n\n", kPeriodTableSize);
+
+  // Protracker note index (C-1 = 0, B-3 = 35) for every period and finetune.
+  // Finetune is a signed nibble, each step is 1/8th of a semitone.
+  printf("static UBYTE PeriodToNote[kNumFinetunes][kPeriodTableSize] = {");
+
+  for (int finetune = 0; finetune < kNumFinetunes; ++ finetune) {
+    int finetune_signed = (finetune < 8) ? finetune : (finetune - kNumFinetunes);
+
+    printf("\n  {");
+
+    for (int period = 0; period < kPeriodTableSize; ++ period) {
+      // Round to the nearest note so periods slightly off the Protracker
+      // tables still land on the intended note.
+      int note = 0;
+
+      if (period > 0) {
+        double semitones = (12.0 * log2((double)kPeriodC1 / period)) - (finetune_signed / 8.0);
+        note = (int)round(semitones);
+        note = (note < 0) ? 0 : ((note >= kNumNotes) ? (kNumNotes - 1) : note);
+      }
+
+      if ((period & 15) == 0) {
+        printf("\n   ");
+      }
+
+      printf(" %2d,", note);
+    }
+
+    printf("\n  },");
+  }
+
+  printf("\n};\n\n");
+
+  // Block color for each note, lowest to highest pitch.
+  printf("static UBYTE NoteToColor[kNumNotes] = {");
+
+  for (int note = 0; note < kNumNotes; ++ note) {
+    if ((note & 7) == 0) {
+      printf("\n ");
+    }
+
+    printf(" %2d,", note / (kNumNotes / kNumBlockColors));
+  }
+
+  printf("\n};\n\n");
+
+  // Onset envelope decay over one division, 8.8 fixed point, indexed by ticks.
+  printf("#define kMaxTicksPerDiv 0x%X\n\n", kMaxTicksPerDiv);
+  printf("static UWORD EnvelopeDecay[kMaxTicksPerDiv + 1] = {");
+
+  for (int ticks = 0; ticks <= kMaxTicksPerDiv; ++ ticks) {
+    if ((ticks & 7) == 0) {
+      printf("\n ");
+    }
+
+    printf(" 0x%03X,", (int)round(pow(kEnvelopeDecayPerTick, ticks) * 0x100));
+  }
+
   printf("\n};\n");
 }
@@ -0,0 +1,233 @@
+// Renders the static track image shown behind the blocks during a game.
+//
+// The image is drawn the same way the blitter would: one pixel per row for
+// each line bordering a filled region, then an inclusive fill of each row
+// from right to left. Rows are interleaved by plane, as in the display.
+//
+// Each row is stored XORed with the row above in the same plane, leaving
+// only the edges that move. This is packed with a simple word run-length
+// encoding which is cheap to unpack on the 68000. A control word with bit 15
+// set repeats the following word (control & 0x7FFF) times, otherwise
+// (control) literal words follow.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+#define ARRAY_NELEMS(x) (sizeof(x) / sizeof((x)[0]))
+
+// Must match gfx.h and gfx.c.
+#define kDispWidth 0x140
+#define kDispHeight 0x100
+#define kDispDepth 3
+#define kDispRowPadW 8
+#define kDispRowBytes ((kDispWidth / 8) + (kDispRowPadW * 2))
+#define kDrawHeight ((4 * kDispHeight) / 5)
+#define kDrawTop (kDispHeight - kDrawHeight)
+#define kDrawCenterX ((kDispRowBytes * 8) / 2)
+#define kFarNearRatio 7
+#define kLaneWidth 123
+#define kBlockWidth ((3 * kLaneWidth) / 5)
+#define kStripeWidth 4
+#define kBorderWidth 17
+
+#define kTrackStrideW ((kDispDepth * kDispRowBytes) / 2)
+#define kTrackSizeW (kDrawHeight * kTrackStrideW)
+#define kRunMaxLen 0x7FFF
+#define kRunMinLen 3
+
+static uint8_t track[kDrawHeight][kDispDepth][kDispRowBytes];
+
+void make_track();
+void draw_line(int plane, int x0, int y0, int x1, int y1);
+void fill_plane(int plane);
+void print_word(uint16_t word);
+void print_packed();
+
+int main() {
+  make_track();
+  print_packed();
+}
+
+void make_track() {
+  // Screen space X near coordinates for lines making up the track.
+  int near_sx[] = {
+    (-kLaneWidth / 2) - (kStripeWidth / 2),      // Left lane stripe left
+    (-kLaneWidth / 2) + (kStripeWidth / 2),      // Left lane stripe right
+    ( kLaneWidth / 2) - (kStripeWidth / 2),      // Right lane stripe left
+    ( kLaneWidth / 2) + (kStripeWidth / 2),      // Right lane stripe right
+    (-(3 * kLaneWidth) / 2) - kBorderWidth,      // Left border left
+    (-(3 * kLaneWidth) / 2),                     // Left border right
+    ( (3 * kLaneWidth) / 2),                     // Right lane left
+    ( (3 * kLaneWidth) / 2) + kBorderWidth,      // Right lane right
+    -kBlockWidth / 2 - kLaneWidth,               // Left lane blocks left
+     kBlockWidth / 2 - kLaneWidth,               // Left lane blocks right
+    -kBlockWidth / 2,                            // Middle lane blocks left
+     kBlockWidth / 2,                            // Middle lane blocks right
+    -kBlockWidth / 2 + kLaneWidth,               // Right lane blocks left
+     kBlockWidth / 2 + kLaneWidth,               // Right lane blocks right
+    -kDrawCenterX,                               // Left screen edge
+     kDrawCenterX - 1,                           // Right screen edge
+    (-(3 * kLaneWidth) / 2) - kBorderWidth - 1,  // Left border edge
+    ( (3 * kLaneWidth) / 2) + kBorderWidth + 1,  // Right border edge
+  };
+
+  int num_lines = ARRAY_NELEMS(near_sx);
+
+  // Project near coordinates to far plane.
+  int far_sx[ARRAY_NELEMS(near_sx)];
+
+  for (int i = 0; i < num_lines - 2; ++ i) {
+    far_sx[i] = near_sx[i];
+
+    if (i < (num_lines - 4)) {
+      far_sx[i] /= kFarNearRatio;
+    }
+  }
+
+  // Outer border edges cannot be projected accurately, just offset from inner.
+  far_sx[num_lines - 2] = far_sx[4] - 1;
+  far_sx[num_lines - 1] = far_sx[7] + 1;
+
+  // 1 = stripe, 2 = left blocks, 3 = middle blocks, 4 = right blocks, 5 = border, 6 = background
+  int colors[] = {1, 1, 1, 1, 5, 5, 5, 5, 2, 2, 3, 3, 4, 4, 6, 6, 6, 6};
+
+  for (int plane = 0; plane < kDispDepth; ++ plane) {
+    // Draw lines bordering filled regions in the corresponding color.
+    for (int i = 0; i < num_lines; ++ i) {
+      if (colors[i] & (1 << plane)) {
+        draw_line(plane, far_sx[i] + kDrawCenterX, kDrawTop,
+                  near_sx[i] + kDrawCenterX, kDispHeight - 1);
+      }
+    }
+
+    // Fill between the lines.
+    fill_plane(plane);
+  }
+}
+
+// Blitter line mode without SING: pixels are ORed into the plane.
+void draw_line(int plane,
+               int x0,
+               int y0,
+               int x1,
+               int y1) {
+  int dx = abs(x1 - x0);
+  int dy = abs(y1 - y0);
+  int dmax = MAX(dx, dy);
+  int dmin = MIN(dx, dy);
+  int step_x = (x1 >= x0) ? 1 : -1;
+  int step_y = (y1 >= y0) ? 1 : -1;
+  int err = (4 * dmin) - (2 * dmax);
+  int x = x0;
+  int y = y0;
+
+  for (int i = 0; i <= dmax; ++ i) {
+    track[y - kDrawTop][plane][x >> 3] |= 0x80 >> (x & 7);
+
+    // Step along the minor axis when the error term is not negative.
+    if (err >= 0) {
+      err += 4 * (dmin - dmax);
+
+      if (dx >= dy) {
+        y += step_y;
+      }
+      else {
+        x += step_x;
+      }
+    }
+    else {
+      err += 4 * dmin;
+    }
+
+    // Always step along the major axis.
+    if (dx >= dy) {
+      x += step_x;
+    }
+    else {
+      y += step_y;
+    }
+  }
+}
+
+// Blitter inclusive fill, right to left, fill carry cleared on each row.
+void fill_plane(int plane) {
+  for (int row = 0; row < kDrawHeight; ++ row) {
+    int carry = 0;
+
+    for (int x = (kDispRowBytes * 8) - 1; x >= 0; -- x) {
+      uint8_t* byte = &track[row][plane][x >> 3];
+      int mask = 0x80 >> (x & 7);
+      int bit = (*byte & mask) ? 1 : 0;
+
+      carry ^= bit;
+
+      if (carry) {
+        *byte |= mask;
+      }
+    }
+  }
+}
+
+void print_word(uint16_t word) {
+  static int num_printed = 0;
+
+  printf("%s0x%04X,", (num_printed ++ % 8 == 0) ? "\n  " : " ", word);
+}
+
+void print_packed() {
+  static uint16_t words[kTrackSizeW];
+  uint8_t* bytes = &track[0][0][0];
+
+  for (int i = 0; i < kTrackSizeW; ++ i) {
+    words[i] = (bytes[i * 2] << 8) | bytes[(i * 2) + 1];
+  }
+
+  for (int i = kTrackSizeW - 1; i >= kTrackStrideW; -- i) {
+    words[i] ^= words[i - kTrackStrideW];
+  }
+
+  printf("#include <exec/types.h>\n");
+  printf("\nstatic UWORD track_packed[] = {");
+
+  for (int i = 0; i < kTrackSizeW; ) {
+    // Measure the run starting here.
+    int run = 1;
+
+    while ((i + run < kTrackSizeW) && (run < kRunMaxLen) && (words[i + run] == words[i])) {
+      ++ run;
+    }
+
+    if (run >= kRunMinLen) {
+      print_word(0x8000 | run);
+      print_word(words[i]);
+      i += run;
+      continue;
+    }
+
+    // Gather literals until the next run worth encoding.
+    int num_lits = 0;
+
+    for (int j = i; (j < kTrackSizeW) && (num_lits < kRunMaxLen); ++ j, ++ num_lits) {
+      if ((j + kRunMinLen <= kTrackSizeW) &&
+          (words[j + 1] == words[j]) && (words[j + 2] == words[j])) {
+        break;
+      }
+    }
+
+    print_word(num_lits);
+
+    for (int j = 0; j < num_lits; ++ j) {
+      print_word(words[i + j]);
+    }
+
+    i += num_lits;
+  }
+
+  printf("\n};\n");
+  printf("#define track_height %d\n", kDrawHeight);
+  printf("#define track_stride %d\n", kDispDepth * kDispRowBytes);
+}
@@ -2,22 +2,206 @@
 
 	section	code
 	public	_update_coplist
+	public	_block_gap_depth
+	public	_draw_top
+
+	;; Modulus for previous (lower) scanline into d0, from this scanline's shift in
+	;; fetch units and the difference to the previous scanline's shift.
+	;; \1: 0 = 16-bit fetch, 1 = 32-bit fetch (AGA FMODE=1)
+	macro	calc_mod
+	move.w	d4,d0			; shift_x
+	ifeq	\1
+	asr.w	#$4,d0			; shift_w = shift_x >> 4
+	move.w	d0,d1
+	add.w	#$3F,d0			; (kDispRowPadW - 1 + ((kDispDepth - 1) * kDispRowBytes / 2) + shift_w)
+	sub.w	d2,d0			; (... + (shift_w - prev_shift_w))
+	asl.w	#$1,d0			; (... + (shift_w - prev_shift_w)) << 1
+	else
+	asr.w	#$5,d0			; shift_l = shift_x >> 5
+	move.w	d0,d1
+	add.w	#$1F,d0			; ((kDispRowPadW / 2) - 1 + ((kDispDepth - 1) * kDispRowBytes / 4) + shift_l)
+	sub.w	d2,d0			; (... + (shift_l - prev_shift_l))
+	asl.w	#$2,d0			; (... + (shift_l - prev_shift_l)) << 2
+	endc
+	move.w	d1,d2			; prev_shift_w = shift_w
+	endm
+
+	;; Sub-fetch shift for this scanline into d0, same delay for both playfields.
+	;; \1: 0 = 16-bit fetch, 1 = 32-bit fetch (AGA FMODE=1)
+	macro	calc_bplcon1
+	move.w	d4,d0
+	and.w	#$F,d0			; shift_x & $F
+	move.w	d0,d1
+	lsl.w	#$4,d1			; (shift_x & $F) << 4
+	or.w	d1,d0			; (shift_x & $F) | ((shift_x & $F) << 4)
+	ifne	\1
+	btst	#$4,d4
+	beq	.no_h6_\@		; (shift_x & $10) == 0
+	or.w	#$4400,d0		; PF1H6 | PF2H6, 16 pixels more delay
+.no_h6_\@:
+	endc
+	endm
+
+	;; Initial modulus in d0 for the scanline preceding the draw area, which
+	;; follows the header modulus, from the top scanline's shift in d2.
+	;; \1: 0 = 16-bit fetch, 1 = 32-bit fetch (AGA FMODE=1)
+	macro	calc_top_mod
+	ifeq	\1
+	move.w	#$86,d0			; ((((3 * kDispRowPadW) / 2) - 1) << 1) + ((kDispDepth - 1) * kDispRowBytes)
+	asl.w	#$1,d2			; prev_shift_w << 1
+	else
+	move.w	#$84,d0			; ((((3 * kDispRowPadW) / 4) - 1) << 2) + ((kDispDepth - 1) * kDispRowBytes)
+	asl.w	#$2,d2			; prev_shift_l << 2
+	endc
+	sub.w	d2,d0			; ... - (prev_shift << fetch unit)
+	endm
+
+
+	;; Values of one scanline as last emitted into a copperlist, CopRow in gfx.c.
+	rsreset
+kRowColor1	rs.w	1
+kRowMod		rs.w	1
+kRowBplcon1	rs.w	1
+kRowStep	rs.w	1
+kRowColor5	rs.w	1
+kRowColor6	rs.w	1		; background gradient, set by gfx.c
+kRowDirty	rs.b	1		; values changed since the row was emitted
+kRowPad		rs.b	1
+kRowStart	rs.l	1		; position of the row's WAIT in the copperlist
+kRowEnd		rs.l	1		; position following the row
+kRowSize	rs.b	0
+
+kBpl1mod	equ	$108
+kBpl2mod	equ	$10A
+kBplcon1	equ	$102
+kColor1		equ	$182
+kColor5		equ	$18A
+kColor6		equ	$18C
 
 	;; a0: UWORD z_until_vu
 	;; a1: UWORD shift_err_inc
 	;; a2: UWORD* colors
-	;; a3: UWORD* cop_row
+	;; a3: UWORD* cop_list (end of rows area, written backwards)
 	;; a4: WORD* z_incs
+	;; a5: CopRow* row (row below the draw area, draw rows follow upwards)
 	;; a6: TrackStep* step
+	;; d0: BOOL shift_changed
+	;; d1: BOOL fetch32, only with MS_AGA
 	;; d2: WORD prev_shift_w
 	;; d3: UWORD z_since_step, UWORD shift_err
 	;; d4: WORD shift_inc, WORD shift_x
 	;; d5: TrackStep step_data
 	;; d6: ULONG z
 	;; d7: UWORD loop_count_top, UWORD loop_count_bottom
+	;; Returns d0: UWORD* start of rows
+
+	;; Each row is a WAIT, a MOVE of the stripe color and MOVEs for only the
+	;; other registers that differ from the row above. Rows are emitted one
+	;; scanline late, once the row above is known.
+	;; A row whose values and the values of the row above are unchanged since
+	;; it was emitted into this copperlist, and which still ends at the same
+	;; position, is left in place. Only its stripe color is rewritten, which
+	;; is why every row holds a MOVE to COLOR1 at the same offset.
+
+	;; Store this row's value (d0) in its record. A change marks this row and
+	;; the row below dirty, as the row below only holds what differs from it.
+	;; \1: row field
+	macro	set_row
+	cmp.w	\1(a5),d0
+	beq	.same_\@
+	move.w	d0,\1(a5)
+	st	kRowDirty(a5)
+	st	kRowDirty-kRowSize(a5)
+.same_\@:
+	endm
+
+	;; Emit a MOVE for the row below if it differs from this row.
+	;; \1: row field, \2: custom register offset
+	macro	emit_move
+	move.w	\1-kRowSize(a5),d0
+	cmp.w	\1(a5),d0
+	beq	.same_\@
+	move.w	d0,-(a3)		; value for row below
+	move.w	#\2,-(a3)		; MOVE register
+.same_\@:
+	endm
+
+	;; Both modulos always share a value.
+	macro	emit_mod
+	move.w	kRowMod-kRowSize(a5),d0
+	cmp.w	kRowMod(a5),d0
+	beq	.same_\@
+	move.w	d0,-(a3)
+	move.w	#kBpl2mod,-(a3)		; MOVE BPL2MOD
+	move.w	d0,-(a3)
+	move.w	#kBpl1mod,-(a3)		; MOVE BPL1MOD
+.same_\@:
+	endm
+
+	;; Lane colors change only where the step (d5) differs from the row below.
+	;; Darken this row's lane, then light the lane below.
+	macro	emit_lanes
+	move.w	kRowStep-kRowSize(a5),d1 ; below_step
+	cmp.w	d1,d5
+	beq	.same_\@
+	move.w	d1,d0
+	rol.w	#$3,d0			; below_step.active_lane to bits 1-2
+	and.w	#$6,d0			; below_step.active_lane << 1
+	beq	.below_dark_\@		; below_step.active_lane == 0
+	and.w	#$FF,d1			; below_step.color offset
+	move.w	(a2,d1.w),-(a3)		; lane_color = colors[below_step.color]
+	add.w	#kColor1,d0
+	move.w	d0,-(a3)		; MOVE COLOR[1 + below_step.active_lane]
+.below_dark_\@:
+	move.w	d5,d0
+	rol.w	#$3,d0			; step_data.active_lane to bits 1-2
+	and.w	#$6,d0			; step_data.active_lane << 1
+	beq	.same_\@		; step_data.active_lane == 0
+	clr.w	-(a3)			; background
+	add.w	#kColor1,d0
+	move.w	d0,-(a3)		; MOVE COLOR[1 + step_data.active_lane]
+.same_\@:
+	endm
+
+	;; Emit the row below, or step over it if it is unchanged in place.
+	;; \1: operand, scanline of this row when d7 = 0
+	macro	emit_row
+	tst.b	kRowDirty-kRowSize(a5)
+	bne	.emit_\@
+	cmp.l	kRowEnd-kRowSize(a5),a3
+	bne	.emit_\@
+	move.l	kRowStart-kRowSize(a5),a3
+	move.w	kRowColor1-kRowSize(a5),6(a3) ; stripe color for row below
+	bra	.done_\@
+
+.emit_\@:
+	move.l	a3,kRowEnd-kRowSize(a5)
+	clr.b	kRowDirty-kRowSize(a5)
+	emit_mod
+	emit_move	kRowBplcon1,kBplcon1
+	emit_move	kRowColor5,kColor5
+	emit_move	kRowColor6,kColor6
+	emit_lanes
+	move.w	kRowColor1-kRowSize(a5),-(a3)
+	move.w	#kColor1,-(a3)		; MOVE COLOR1, always at offset 4
+	move.w	#$FFFE,-(a3)
+	move.w	d7,d0
+	add.w	\1,d0
+	addq.w	#$1,d0			; scanline below
+	lsl.w	#$8,d0
+	addq.w	#$1,d0
+	move.w	d0,-(a3)		; WAIT (scanline below, 1)
+	move.l	a3,kRowStart-kRowSize(a5)
+.done_\@:
+	endm
 
+	;; \1: 1 = rewrite scroll registers, 0 = camera X unchanged since last update
+	;; \2: operand, scanline when d7 = 0
+	;; \3: 1 = 32-bit fetch
 	macro	scanline_loop
 .prev_scanline_\@:
+	lea	kRowSize(a5),a5		; row = this scanline
+
 	;; Calculate world Z for this scanline.
 	moveq	#$0,d0
 	move.w	(a4)+,d0		; z_inc = *(z_incs ++)
@@ -25,35 +209,22 @@
 	add.w	d0,d3			; z_since_step += z_inc
 
 	;; Advance step if Z crossed a step boundary.
-	move.w	#$DB6,d0		; kBlockGapDepth
+	move.w	_block_gap_depth,d0
 	cmp.w	d0,d3
-	blt	.no_step_\@		; z_since_step < kBlockGapDepth
-	sub.w	d0,d3			; z_since_step -= kBlockGapDepth
+	blt	.no_step_\@		; z_since_step < block_gap_depth
+	sub.w	d0,d3			; z_since_step -= block_gap_depth
 	move.w	(a6)+,d5		; step_data = *(++ step)
 	.no_step_\@:
 
+	ifne	\1
 	;; Calculate shift for this scanline and modulus for previous (lower) scanline.
-	;; Adjust modulus by difference between previous and current scanline shift.
-	move.w	d4,d0			; shift_x
-	asr.w	#$4,d0			; shift_w = shift_x >> 4
-	move.w	d0,d1
-	addq.w	#$7,d0			; (kDispRowPadW - 1 + shift_w)
-	sub.w	d2,d0			; (kDispRowPadW - 1 + (shift_w - prev_shift_w))
-	asl.w	#$1,d0			; (kDispRowPadW - 1 + (shift_w - prev_shift_w)) << 1
-	move.w	d1,d2			; prev_shift_w = shift_w
-
-	lea	-$28(a3),a3		; cop_row -= 1 scanline
-	move.w	d0,$6(a3)		; BPL1MOD
-	move.w	d0,$A(a3)		; BPL2MOD
-
-	;; Set up sub-word shift for this scanline.
-	move.w	d4,d0
-	and.w	#$F,d0			; shift_x & $F
-	move.w	d0,d1
-	lsl.w	#$4,d1			; (shift_x & $F) << 4
-	or.w	d1,d0			; (shift_x & $F) | ((shift_x & $F) << 4)
+	calc_mod	\3
+	set_row	kRowMod
 
-	move.w	d0,$E(a3)		; BPLCON1
+	;; Set up sub-fetch shift for this scanline.
+	calc_bplcon1	\3
+	set_row	kRowBplcon1
+	endc
 
 	;; Cycle stripe color with camera movement through Z.
 	move.w	d6,d1			; z
@@ -66,33 +237,23 @@
 	beq	.no_stripe_\@		; (z & $1000) == 0
 	move.w	d1,d0			; stripe_color = foreground
 .no_stripe_\@:
-	move.w	d0,$12(a3)		; COLOR1 = stripe_color
-
-	;; Begin with all lane colors set to background.
-	moveq	#$0,d0
-	move.w	d0,$16(a3)		; COLOR2
-	move.w	d0,$1A(a3)		; COLOR3
-	move.w	d0,$1E(a3)		; COLOR4
+	move.w	d0,kRowColor1(a5)
 
 	;; Color the border according to VU meter position.
+	moveq	#$0,d0			; offset to dark color
 	cmp.l	a0,d6
 	bgt	.set_border_\@		; z > vu_meter_z
 	moveq	#2,d0			; offset to vu_meter color
 .set_border_\@:
-	move.w	$30(a2,d0.w),$22(a3)	; COLOR5 = vu_meter or dark
+	move.w	$30(a2,d0.w),d0		; vu_meter or dark
+	set_row	kRowColor5
 
-	;; Determine whether any lane is active in this step.
-	move.w	d5,d1			; step_data
-	rol.w	#$4,d1			; 12'X, step_data.active_lane, 2'X
-	and.w	#$C,d1			; step_data.active_lane << 2
-	beq	.no_lane_\@		; step_data.active_lane == 0
+	move.w	d5,d0
+	set_row	kRowStep
 
-	;; Color the step according to its pitch.
-	move.b	d5,d0			; step_data
-	move.w	(a2,d0.w),d0		; lane_color = colors[step_data.color]
-	move.w	d0,$12(a3,d1.w)		; COLOR[1 + step_data.active_lane] = lane_color
-.no_lane_\@:
+	emit_row	\2
 
+	ifne	\1
 	;; Accumulate fixed-point fractional shift for this scanline.
 	;; When it spills +1/2 pixel subtract 1 pixel and advance by one pixel (left/right).
 	swap	d3			; shift_err to low word
@@ -105,28 +266,83 @@
 	add.w	d0,d4			; shift_x += shift_x_inc
 .no_shift_\@:
 	swap	d3			; shift_err_inc to low word
+	endc
 
 	;; Repeat for all scanlines in the segment.
 	dbf	d7,.prev_scanline_\@
 	endm
 
+	;; \1: 1 = rewrite scroll registers, 0 = camera X unchanged since last update
+	;; \2: 1 = 32-bit fetch
+	macro	update_rows
+	;; Loop counts are segmented around extra wait on scanline $100.
+	;; Scanline $FF emits the row for $100, which the extra wait must precede.
+	;; The top segment ends at the first draw scanline of the selected detail.
+	scanline_loop	\1,#$100,\2	; Bottom segment of display
+	clr.w	d7
+	scanline_loop	\1,#$FF,\2	; Scanline $FF
+	move.l	#$FFDFFFFE,-(a3)	; Extra wait for high bit rollover
+	swap	d7
+	subq.w	#$1,d7			; Remaining scanline count - 1
+	scanline_loop	\1,_draw_top,\2	; Top segment of display
+
+	;; Scanline preceding draw area follows the header, which zeroes all
+	;; registers except for the modulus.
+	lea	kRowSize(a5),a5
+	ifne	\1
+	calc_top_mod	\2
+	set_row	kRowMod
+	endc
+	endm
+
 _update_coplist:
-	movem.l	d0-d7/a0-a6,-(sp)
-	moveq	#$0,d2			; prev_shift_w = 0
+	movem.l	d1-d7/a0-a6,-(sp)
 	move.w	(a6)+,d5		; step_data = *(++ step)
+	tst.w	d0
+	beq	.shift_unchanged	; Scroll registers already hold this camera X
+	moveq	#$0,d2			; prev_shift_w = 0
+	ifd	MS_AGA
+	tst.w	d1
+	bne	.fetch32
+	endc
+	update_rows	1,0
+	bra	.done
+
+	ifd	MS_AGA
+.fetch32:
+	update_rows	1,1
+	bra	.done
+	endc
+
+.shift_unchanged:
+	update_rows	0,0
 
-	;; Copperlist is segmented around extra wait on scanline $100.
-	scanline_loop			; Bottom segment of display
-	subq.l	#$4,a3			; Step backwards over extra wait
-	swap	d7			; Remaining scanline count - 1
-	scanline_loop			; Top segment of display
+.done:
+	moveq	#$0,d5			; no lane lit
+	emit_row	_draw_top
+	clr.b	kRowDirty(a5)
 
 	;; Set up initial shift in top scanline preceding draw area.
-	move.w	#$16,d0			; (((3 * kDispRowPadW) / 2) - 1) << 1
-	asl.w	#$1,d2			; prev_shift_w << 1
-	sub.w	d2,d0			; ((3 * kDispRowPadW) / 2) - 1 - prev_shift_w) << 1
-	move.w	d0,-$22(a3)		; BPL1MOD
-	move.w	d0,-$1E(a3)		; BPL2MOD
+	;; Scanlines above keep the header modulus and black colors.
+	move.w	kRowMod(a5),d0
+	move.w	d0,-(a3)
+	move.w	#kBpl2mod,-(a3)		; MOVE BPL2MOD
+	move.w	d0,-(a3)
+	move.w	#kBpl1mod,-(a3)		; MOVE BPL1MOD
+	move.w	#$FFFE,-(a3)
+	move.w	_draw_top,d0
+	subq.w	#$1,d0			; first draw scanline - 1
+	lsl.w	#$8,d0
+	addq.w	#$1,d0
+	move.w	d0,-(a3)		; WAIT (first draw scanline - 1, 1)
 
-	movem.l	(sp)+,d0-d7/a0-a6
+	move.l	a3,d0
+	movem.l	(sp)+,d1-d7/a0-a6
 	rts
+
+
+	;; Set by gfx.c for the selected detail.
+_block_gap_depth:
+	dc.w	$DB6			; Z distance between steps
+_draw_top:
+	dc.w	$60			; first draw scanline
@@ -2,10 +2,13 @@
 #include "blit.h"
 #include "build/ball.h"
 #include "build/images.h"
+#include "build/track.h"
 #include "custom.h"
 #include "module.h"
+#include "profile.h"
 #include "system.h"
 
+#include <exec/execbase.h>
 #include <proto/exec.h>
 #include <proto/graphics.h>
 #include <stddef.h>
@@ -17,54 +20,97 @@
 #define kDispFetchStart ((kDispFetchX / 0x2) - kDispRes - 8)
 #define kDispFetchStop ((kDispFetchX / 0x2) - kDispRes + (0x8 * ((kDispWidth / 0x10) - 1)))
 #define kDispFetchExtraWord 0x1 // extra word fetched for horizontal scrolling
+#define kDispHdrModulo (((kDispRowPadW - kDispFetchExtraWord) * kBytesPerWord) + (kDispStride - kDispSlice))
+#define kDispFetch32Start (kDispFetchStart - 0x8) // AGA FMODE=1, extra 32-bit fetch
+#define kDispFetch32Stop (kDispFetchStop - 0x8)
+#define kDispFetch32ExtraWords 0x2
+#define kDispHdrModulo32 (((kDispRowPadW - kDispFetch32ExtraWords) * kBytesPerWord) + (kDispStride - kDispSlice))
 #define kDrawHeight ((4 * kDispHeight) / 5)
 #define kDrawTop (kDispHeight - kDrawHeight)
-#define kDispCopListSizeW (404 + ((kDrawHeight + 1) * 20))
+#define kDispCopListSizeW (412 + ((kDrawHeight + 1) * 20)) // + jump to variable-length rows
 #define kHeaderTextTop (logo_height + ((kDispHdrHeight - logo_height - kFontHeight) / 2))
 #define kHeaderTextGap 60
 #define kHeaderTextPen 5
 #define kHeaderScoreLeft ((kDispWidth - 20) - (6 * kFontSpacing))
+#define kDebugTextLeft 8
+#define kTextLineMaxChars ((kDispWidth / kFontSpacing) + 1)
+#define kTextLineSizeW ((((kTextLineMaxChars * kFontSpacing) + 0xF) >> 4) + 2) // + phase, + last longword
+#define kTextNumLines 8 // line buffers in flight before a fence
+#define kDebugTextMaxChars 15 // Fits left of the widest title
 #define kPtrSprEdge 0x10
 #define kPtrSprOffX -6
 #define kPtrSprOffY -1
-#define kBallZ (kNearZ + (kNumStepsDelay * kBlockGapDepth))
-#define kBlockWidth ((3 * kLaneWidth) / 5)
-#define kStripeWidth 4
-#define kBorderWidth 17
 #define kHeaderPalette 0xB8C, 0x425, 0x94A
 #define kFadeActionNumColors 52
+#define kFadeMenuNumColors 5
+#define kFadeNumLevels 0x10 // One level per step of a 4-bit color component
 #define kBallEdge 0x20
 #define kBallAngleLimit (((((kBallNumAngles * 2) + 1) << 11) / 2) - 1)
 #define kBallMouseRotateShift 7
 
+// Values of one scanline as last emitted into a copperlist, kRow* in gfx.asm.
+typedef struct {
+  UWORD color1;
+  UWORD mod;
+  UWORD bplcon1;
+  UWORD step;
+  UWORD color5;
+  UWORD color6;  // Background gradient, set here rather than by update_coplist
+  UBYTE dirty;   // Values changed since the row was emitted
+  UBYTE pad;
+  UWORD* start;  // Position of the row's WAIT in the copperlist
+  UWORD* end;    // Position following the row
+} CopRow;
+
+// Row below the draw area, draw rows from the bottom up, then the row preceding them.
+#define kNumCopRows (kDrawHeight + 2)
+
 // Defined in gfx.asm
-extern void update_coplist(UWORD* colors __asm("a2"),
-                           UWORD* cop_row __asm("a3"),
-                           UWORD* z_incs __asm("a4"),
-                           TrackStep* step_near __asm("a6"),
-                           ULONG step_frac __asm("d3"),
-                           ULONG shift_params __asm("d4"),
-                           ULONG vu_meter_z __asm("a0"),
-                           UWORD shift_err_inc __asm("a1"),
-                           ULONG z __asm("d6"),
-                           ULONG loop_counts __asm("d7"));
+extern UWORD block_gap_depth;
+extern UWORD draw_top; // first draw scanline
+
+// Returns the start of the variable-length rows, which end at cop_list_end.
+extern UWORD* update_coplist(UWORD* colors __asm("a2"),
+                             UWORD* cop_list_end __asm("a3"),
+                             UWORD* z_incs __asm("a4"),
+                             CopRow* rows __asm("a5"),
+                             TrackStep* step_near __asm("a6"),
+                             BOOL shift_changed __asm("d0"),
+                             BOOL fetch32 __asm("d1"),
+                             ULONG step_frac __asm("d3"),
+                             ULONG shift_params __asm("d4"),
+                             ULONG vu_meter_z __asm("a0"),
+                             UWORD shift_err_inc __asm("a1"),
+                             ULONG z __asm("d6"),
+                             ULONG loop_counts __asm("d7"));
 
 static Status make_copperlists();
 static UWORD* make_copperlist_score(UWORD* cl);
 static Status make_view();
 static void make_z_incs();
-static BOOL fade_common(UWORD* colors_lo,
-                        UWORD* colors_hi,
-                        UWORD num_colors,
-                        BOOL fade_in);
+static void reset_row_cache();
+static void make_track();
+static void make_font_shifted();
+static void unpack_track(UWORD* dst);
+static void make_fade_levels(UWORD* colors,
+                             UWORD num_colors,
+                             UWORD* levels);
 static void update_score(UWORD* cop_list,
                          UWORD score_frac);
 static void update_sprite(UWORD* cop_list, UWORD sprite_x, UWORD camera_z_inc);
+static WORD project_ball_x(WORD ball_x);
+static ULONG ball_ctl_words(UWORD sprite_x,
+                            UWORD spr_idx);
+static void level3_int(UWORD intreq __asm("d0"));
 static void update_sprite_colors(UWORD* cop_list,
                                  ULONG camera_z);
 
 static struct {
   UWORD cop_list_back;
+  UWORD cop_list_bound;            // copperlist last written to COP1LC
+  UWORD cop_list_front;            // copperlist on display, follows COP1LC at vertical blank
+  WORD latch_sprite_x[2];          // ball sprite X less projected ball X, per copperlist
+  WORD (*ball_latch)();            // late ball X for the copper interrupt, NULL if none
   UWORD cop_list_spr_color_idx;
   UWORD cop_list_menu_end_idx;
   UWORD cop_list_rows_start;
@@ -74,22 +120,78 @@ static struct {
   struct View view;
   struct ViewPort viewport;
   UWORD z_incs[kDrawHeight];
-  UWORD colors[kFadeActionNumColors];
+  UWORD* track_planes; // resident unpacked track, NULL if chip RAM was short
+  BOOL fetch32;        // AGA 32-bit bitplane fetch (AGA=1 builds), scrolls in 32 pixel units
+  UWORD num_visible_steps;
+  UWORD draw_height;               // scanlines drawn up from the bottom, the rest stay black
+  UWORD ball_y;
+  UWORD* colors;                   // current gameplay fade level
+  UWORD play_level;
+  UWORD play_levels[kFadeNumLevels][kFadeActionNumColors];
+  UWORD menu_levels[kFadeNumLevels][kFadeMenuNumColors];
+  ULONG font_shifted[kFontNGlyphs][0x10][kFontHeight]; // glyph rows at each pixel phase
+  ULONG font_cell_masks[0x10];     // glyph cell at each pixel phase
+  UWORD text_line;                 // line buffer last composed
+  UWORD cop_list_jump_idx;
+  CopRow rows[2][kNumCopRows]; // per copperlist
+  WORD row_camera_x[2];        // camera X last drawn, per copperlist
 } g;
 
 // Prevent BSS section merging with .data_chip
 #define __chip_bss __attribute__((section(".bsschip")))
 
-static UWORD disp_planes[kDispDepth][kDispHeight + kDispColPad][kDispStride / kBytesPerWord] __chip_bss;
+// 32-bit fetch requires plane pointers and modulos aligned to 4 bytes.
+static UWORD disp_planes[kDispHeight + kDispColPad][kDispDepth][kDispRowBytes / kBytesPerWord]
+  __attribute__((aligned(4))) __chip_bss;
 static UWORD cop_lists[2][kDispCopListSizeW] __chip_bss;
 static UWORD null_spr[2] __chip_bss;
 
+// Text composed by the CPU and blitted once per plane, see gfx_draw_text.
+// Row 0 masks the glyph cells, rows 1+ hold the glyphs.
+static UWORD text_lines[kTextNumLines][kFontHeight + 1][kTextLineSizeW] __chip_bss;
+
+// Menu body (below header) uses colors 1-4, mouse pointer uses color 18.
+static UWORD menu_colors[kFadeMenuNumColors] = {0x425, 0xB4C, 0xB8C, 0x5C5, 0xDB9};
+
+static UWORD play_colors[kFadeActionNumColors] = {
+  // Active block colors, from lowest to highest pitch
+  0x810, 0x910, 0xA20, 0xB20, 0xB30, 0xC40, 0xD50, 0xD60, 0xD70, 0xE80, 0xE90, 0xFA0,
+  // Inactive block colors, from lowest to highest pitch
+  0x300, 0x300, 0x310, 0x310, 0x310, 0x410, 0x420, 0x420, 0x420, 0x430, 0x430, 0x530,
+  // Track edge background/foreground
+  0x303, 0x704,
+  // Ball pattern
+  0xA00, 0xDBB,
+  // Track stripe gradient
+  0x505, 0x606, 0x606, 0x707, 0x707, 0x808, 0x909, 0x909,
+  0xA0A, 0x909, 0x808, 0x808, 0x707, 0x707, 0x606, 0x505,
+  // Background gradient
+  0x000, 0x001, 0x002, 0x003, 0x004, 0x005, 0x006, 0x007,
+};
+
+typedef struct {
+  UWORD num_visible_steps;
+  UWORD draw_height;
+} Detail;
+
+static Detail details[kNumGfxDetails] = {
+  [GfxDetailShort]  = {kNumVisibleSteps, kDrawHeight - 48}, // Skips the far quarter of scanlines
+  [GfxDetailNormal] = {kNumVisibleSteps, kDrawHeight},
+  [GfxDetailFar]    = {kMaxVisibleSteps, kDrawHeight},
+};
+
 Status gfx_init() {
   Status status = StatusOK;
 
   ASSERT(make_copperlists());
   ASSERT(make_view());
   make_z_incs();
+  make_track();
+  make_font_shifted();
+  make_fade_levels(menu_colors, kFadeMenuNumColors, &g.menu_levels[0][0]);
+  make_fade_levels(play_colors, kFadeActionNumColors, &g.play_levels[0][0]);
+  g.colors = g.play_levels[0];
+  gfx_select_detail(gfx_default_detail());
 
   system_load_view(&g.view);
 
@@ -141,18 +243,27 @@ static Status make_copperlists() {
   *(cl ++) = CUSTOM_OFFSET(diwhigh);
   *(cl ++) = (1 << DIWHIGH_H10_SHF) | (1 << DIWHIGH_V8_SHF);
 
+#ifdef MS_AGA
+  // AGA fetches 32 bits of each plane at a time, halving bitplane DMA slots.
+  // Scrolling then needs an extra 32-bit fetch and modulos in 4 byte steps.
+  g.fetch32 = system_is_aga();
+#endif
+
+  UWORD fetch_extra_words = g.fetch32 ? kDispFetch32ExtraWords : kDispFetchExtraWord;
+  UWORD hdr_modulo = g.fetch32 ? kDispHdrModulo32 : kDispHdrModulo;
+
   *(cl ++) = CUSTOM_OFFSET(ddfstrt);
-  *(cl ++) = kDispFetchStart;
+  *(cl ++) = g.fetch32 ? kDispFetch32Start : kDispFetchStart;
   *(cl ++) = CUSTOM_OFFSET(ddfstop);
-  *(cl ++) = kDispFetchStop;
+  *(cl ++) = g.fetch32 ? kDispFetch32Stop : kDispFetchStop;
 
   *(cl ++) = CUSTOM_OFFSET(bplcon4);
   *(cl ++) = 0x11;
   *(cl ++) = CUSTOM_OFFSET(fmode);
-  *(cl ++) = 0;
+  *(cl ++) = g.fetch32 ? FMODE_BPL32 : 0;
 
   for (UWORD i = 0; i < kDispDepth; ++ i) {
-    ULONG plane_start = (ULONG)&disp_planes[i][0][0] - (kDispFetchExtraWord * kBytesPerWord);
+    ULONG plane_start = (ULONG)&disp_planes[0][i][0] - (fetch_extra_words * kBytesPerWord);
 
     *(cl ++) = CUSTOM_OFFSET(bplpt[i]);
     *(cl ++) = WORD_HI(plane_start);
@@ -160,11 +271,11 @@ static Status make_copperlists() {
     *(cl ++) = WORD_LO(plane_start);
   }
 
-  // Header uses constant scroll/modulus.
+  // Header uses constant scroll/modulus, skipping the other interleaved planes.
   *(cl ++) = CUSTOM_OFFSET(bpl1mod);
-  *(cl ++) = (kDispRowPadW - kDispFetchExtraWord) * kBytesPerWord;
+  *(cl ++) = hdr_modulo;
   *(cl ++) = CUSTOM_OFFSET(bpl2mod);
-  *(cl ++) = (kDispRowPadW - kDispFetchExtraWord) * kBytesPerWord;
+  *(cl ++) = hdr_modulo;
 
   *(cl ++) = CUSTOM_OFFSET(bplcon0);
   *(cl ++) = BPLCON0_COLOR;
@@ -195,10 +306,27 @@ static Status make_copperlists() {
     *(cl ++) = 0;
   }
 
+  // Interrupt before the track rows, ahead of the ball, to late latch its position.
+  *(cl ++) = CUSTOM_OFFSET(intreq);
+  *(cl ++) = INTREQ_SET | INTREQ_COPER;
+
   // One extra row to set modulus for first draw line.
   UWORD start_y = kDispWinY + kDrawTop - 1;
   UWORD stop_y = kDispWinY + kDispHeight;
 
+  // Jump to the rows emitted by gfx_update_display, which only hold the MOVEs
+  // that change from one scanline to the next and end where the tail begins.
+  // Until then, jump to the full rows built below.
+  g.cop_list_jump_idx = cl - cop_lists[0];
+  ULONG rows_start = (ULONG)(cl + 6);
+
+  *(cl ++) = CUSTOM_OFFSET(cop2lc);
+  *(cl ++) = WORD_HI(rows_start);
+  *(cl ++) = CUSTOM_OFFSET(cop2lc) + kBytesPerWord;
+  *(cl ++) = WORD_LO(rows_start);
+  *(cl ++) = CUSTOM_OFFSET(copjmp2);
+  *(cl ++) = 0;
+
   g.cop_list_rows_start = cl - cop_lists[0];
 
   for (UWORD disp_y = start_y; disp_y < stop_y; ++ disp_y) {
@@ -256,6 +384,11 @@ static Status make_copperlists() {
   // Copy the front copperlist we built to the back copperlist.
   CopyMem(cop_lists[0], cop_lists[1], sizeof(cop_lists[0]));
 
+  // Back copperlist jumps to its own rows.
+  ULONG back_rows_start = (ULONG)&cop_lists[1][g.cop_list_rows_start];
+  cop_lists[1][g.cop_list_jump_idx + 1] = WORD_HI(back_rows_start);
+  cop_lists[1][g.cop_list_jump_idx + 3] = WORD_LO(back_rows_start);
+
   // Setup copperlist for menu initially.
   gfx_setup_copperlist(TRUE);
 
@@ -357,6 +490,120 @@ static void make_z_incs() {
   }
 }
 
+#define kRowCameraXNone -0x8000 // never a valid camera X
+
+static void reset_row_cache() {
+  // Every row is emitted again on the next update of each copperlist.
+  for (UWORD i = 0; i < 2; ++ i) {
+    for (UWORD j = 0; j < kNumCopRows; ++ j) {
+      CopRow* row = &g.rows[i][j];
+
+      // Background gradient steps every 32 scanlines, black outside the draw area.
+      UWORD disp_y = kDispHeight - j;
+      row->color6 = ((j > 0) && (j <= g.draw_height)) ? g.colors[44 + (disp_y >> 5)] : 0;
+      row->dirty = TRUE;
+      row->end = NULL;
+    }
+
+    g.row_camera_x[i] = kRowCameraXNone;
+  }
+}
+
+UWORD gfx_default_detail() {
+  // 68000/010 update fewer scanlines, 68030 and up show more steps ahead.
+  UWORD attn_flags = SysBase->AttnFlags;
+
+  return (attn_flags & (1U << AFB_68030)) ? GfxDetailFar :
+         ((attn_flags & (1U << AFB_68020)) ? GfxDetailNormal : GfxDetailShort);
+}
+
+void gfx_select_detail(UWORD detail) {
+  g.num_visible_steps = details[detail].num_visible_steps;
+  g.draw_height = details[detail].draw_height;
+
+  // Steps divide the same depth between near and far planes.
+  block_gap_depth = (kFarZ - kNearZ + 1) / g.num_visible_steps;
+
+  // Project ball Z position, one step delay beyond the near plane, to screen Y.
+  ULONG ball_z = kNearZ + (kNumStepsDelay * block_gap_depth);
+  UWORD z_frac = ((ULONG)(kNearZ - 1) << 0x10) / ball_z;
+  g.ball_y = ((ULONG)(z_frac - kNearZ) * kDrawHeight) / (0x10000 - kNearZ)
+           + (kDispHeight - kDrawHeight) - (kBallEdge / 2);
+
+  draw_top = kDispWinY + kDispHeight - g.draw_height;
+
+  // Row records follow the draw height, emit every row again.
+  reset_row_cache();
+}
+
+UWORD gfx_num_visible_steps() {
+  return g.num_visible_steps;
+}
+
+UWORD gfx_block_gap_depth() {
+  return block_gap_depth;
+}
+
+#if (track_height != kDrawHeight) || (track_stride != kDispStride)
+#error "build/track.h does not match the display layout"
+#endif
+
+#define kTrackStrideW (kDispStride / kBytesPerWord)
+#define kTrackSizeB (kDrawHeight * kDispStride)
+
+static void make_track() {
+  // Keep the track resident in chip RAM when there is room, so a game can
+  // start with one blit. Otherwise it is unpacked into the display each time.
+  if ((g.track_planes = AllocMem(kTrackSizeB, MEMF_CHIP))) {
+    unpack_track(g.track_planes);
+  }
+}
+
+// See gentrack.c for the packed format.
+static void unpack_track(UWORD* dst) {
+  UWORD* src = track_packed;
+  UWORD* src_end = src + ARRAY_NELEMS(track_packed);
+  UWORD* dst_start = dst;
+
+  while (src < src_end) {
+    UWORD control = *(src ++);
+
+    if (control & 0x8000) {
+      UWORD word = *(src ++);
+
+      for (UWORD i = control & 0x7FFF; i > 0; -- i) {
+        *(dst ++) = word;
+      }
+    }
+    else {
+      for (UWORD i = control; i > 0; -- i) {
+        *(dst ++) = *(src ++);
+      }
+    }
+  }
+
+  // Rows are stored as differences from the row above.
+  for (dst = dst_start + kTrackStrideW; dst < dst_start + (kTrackSizeB / kBytesPerWord); ++ dst) {
+    *dst ^= dst[-kTrackStrideW];
+  }
+}
+
+static void make_font_shifted() {
+  // Font image holds one row of every glyph after another, glyph in the top bits.
+  // Each glyph is shifted to every phase within a word once, leaving text
+  // drawing with aligned longword ORs only.
+  for (UWORD shift = 0; shift < 0x10; ++ shift) {
+    g.font_cell_masks[shift] = 0xF8000000 >> shift;
+
+    for (UWORD glyph_idx = 0; glyph_idx < kFontNGlyphs; ++ glyph_idx) {
+      for (UWORD row = 0; row < kFontHeight; ++ row) {
+        ULONG glyph = (ULONG)(font_planes[(row * kFontNGlyphs) + glyph_idx] & 0xF800) << 16;
+        g.font_shifted[glyph_idx][shift][row] = glyph >> shift;
+      }
+    }
+  }
+}
+
 static Status make_view() {
   Status status = StatusOK;
 
@@ -379,6 +626,11 @@ cleanup:
 
 void gfx_fini() {
   system_unload_view();
+
+  if (g.track_planes) {
+    FreeMem(g.track_planes, kTrackSizeB);
+    g.track_planes = NULL;
+  }
 }
 
 UBYTE* gfx_display_planes() {
@@ -408,13 +660,84 @@ void gfx_draw_text(STRPTR text,
                    UWORD top,
                    UWORD color,
                    BOOL replace_bg) {
-  APTR dst_row_base = gfx_display_planes() + (top * kDispStride);
+  UWORD num_chars = 0;
+
+  while (text[num_chars] && (num_chars < MIN(max_chars, kTextLineMaxChars))) {
+    ++ num_chars;
+  }
+
+  if (num_chars == 0) {
+    return;
+  }
+
+  // Blits queued from earlier lines may still read the buffers about to be reused.
+  if (++ g.text_line == kTextNumLines) {
+    g.text_line = 0;
+    blit_fence();
+  }
+
+  // Compose the line at the destination's pixel phase, so every plane
+  // takes a single unshifted blit.
+  UWORD* line = &text_lines[g.text_line][0][0];
+  UWORD phase = left & 0xF;
+  UWORD shift = phase;
+  UWORD* line_word = line;
+
+  memory_clear(line, sizeof(text_lines[0]));
 
-  for (UWORD char_idx = 0; text[char_idx] && max_chars; ++ char_idx, -- max_chars) {
+  for (UWORD char_idx = 0; char_idx < num_chars; ++ char_idx) {
     UWORD glyph_idx = MIN(MAX(0x20, text[char_idx]) - 0x20, kFontNGlyphs - 1);
-    blit_char((UBYTE*)font_planes, glyph_idx, dst_row_base, left, color, replace_bg);
+    ULONG* glyph = g.font_shifted[glyph_idx][shift];
+    UWORD* dst = line_word;
+
+    *(ULONG*)dst |= g.font_cell_masks[shift];
+
+    for (UWORD row = 0; row < kFontHeight; ++ row) {
+      dst += kTextLineSizeW;
+      *(ULONG*)dst |= *(glyph ++);
+    }
+
+    // Step to the next glyph's phase, moving on a word when it wraps.
+    shift += kFontSpacing;
+
+    if (shift >= 0x10) {
+      shift -= 0x10;
+      ++ line_word;
+    }
+  }
+
+  UWORD width_words = (phase + (num_chars * kFontSpacing) - 1 + 0xF) >> 4;
+  APTR dst_base = gfx_display_planes() + (top * kDispStride) + ((left >> 4) << 1);
 
-    left += kFontSpacing;
+  blit_text_line(line, kTextLineSizeW * kBytesPerWord, width_words, dst_base, color, replace_bg);
+}
+
+void gfx_draw_debug_text(STRPTR text) {
+  // Drawn by the CPU, the copper owns the blitter during play.
+  // Padded with spaces to replace any previous text.
+  UBYTE* row_base = gfx_display_planes() + (kHeaderTextTop * kDispStride);
+  UWORD left = kDebugTextLeft;
+  BOOL text_ended = FALSE;
+
+  for (UWORD char_idx = 0; char_idx < kDebugTextMaxChars; ++ char_idx, left += kFontSpacing) {
+    text_ended = text_ended || (text[char_idx] == '\0');
+
+    BYTE c = text_ended ? ' ' : text[char_idx];
+    UWORD glyph_idx = MIN(MAX(0x20, c) - 0x20, kFontNGlyphs - 1);
+
+    // Glyph and spacing column at the top of a longword, shifted into place.
+    UWORD shift = left & 0xF;
+    ULONG mask = ~(0xFC000000 >> shift);
+    UBYTE* dst_base = row_base + ((left >> 4) << 1);
+
+    for (UWORD row = 0; row < kFontHeight; ++ row) {
+      ULONG glyph = g.font_shifted[glyph_idx][shift][row];
+
+      for (UWORD plane_idx = 0; plane_idx < kDispDepth; ++ plane_idx) {
+        ULONG* dst = (ULONG*)(dst_base + (plane_idx * kDispSlice) + (row * kDispStride));
+        *dst = (*dst & mask) | ((kHeaderTextPen & (1 << plane_idx)) ? glyph : 0);
+      }
+    }
   }
 }
 
@@ -433,7 +756,7 @@ void gfx_draw_logo() {
     UBYTE* logo_plane = (UBYTE*)logo_planes + (i * logo_plane_stride);
 
     for (UWORD pass = 0; pass < 2; ++ pass) {
-      UBYTE* disp_plane = (UBYTE*)&disp_planes[pass == 0 ? i : 2][0][0];
+      UBYTE* disp_plane = (UBYTE*)&disp_planes[0][pass == 0 ? i : 2][0];
 
       blit_copy(logo_plane, logo_row_stride, 0, 0,
                 disp_plane, kDispStride, 0, 0, logo_width, logo_height, pass == 0, FALSE);
@@ -466,17 +789,10 @@ void gfx_init_score() {
   gfx_draw_text("  0.0%", -1, kHeaderScoreLeft, kHeaderTextTop, kHeaderTextPen, TRUE);
 }
 
-#define kFadeMenuNumColors 5
-
 void gfx_fade_menu(BOOL fade_in) {
-  // Menu body (below header) uses colors 1-4, mouse pointer uses color 18.
-  UWORD colors_lo[kFadeMenuNumColors] = {0x000};
-  UWORD colors_hi[kFadeMenuNumColors] = {0x425, 0xB4C, 0xB8C, 0x5C5, 0xDB9};
-  UWORD* colors = fade_in ? colors_lo : colors_hi;
-
-  // Fade colors to/from black, one step every two frames.
-  for (BOOL fading = TRUE; fading; ) {
-    fading = fade_common(colors_lo, colors_hi, kFadeMenuNumColors, fade_in);
+  // Fade colors to/from black, one level every two frames.
+  for (UWORD step = 1; step < kFadeNumLevels; ++ step) {
+    UWORD* colors = g.menu_levels[fade_in ? step : (kFadeNumLevels - 1 - step)];
 
     for (UWORD i = 0; i < 4; ++ i) {
       cop_lists[0][35 + (i * 2)] = colors[i];
@@ -492,143 +808,57 @@ void gfx_fade_menu(BOOL fade_in) {
 
 void gfx_fade_play(BOOL fade_in,
                    BOOL delay_fade) {
-  static UWORD colors_lo[kFadeActionNumColors] = {0x000};
-  static UWORD colors_hi[kFadeActionNumColors] = {
-    // Active block colors, from lowest to highest pitch
-    0x810, 0x910, 0xA20, 0xB20, 0xB30, 0xC40, 0xD50, 0xD60, 0xD70, 0xE80, 0xE90, 0xFA0,
-    // Inactive block colors, from lowest to highest pitch
-    0x300, 0x300, 0x310, 0x310, 0x310, 0x410, 0x420, 0x420, 0x420, 0x430, 0x430, 0x530,
-    // Track edge background/foreground
-    0x303, 0x704,
-    // Ball pattern
-    0xA00, 0xDBB,
-    // Track stripe gradient
-    0x505, 0x606, 0x606, 0x707, 0x707, 0x808, 0x909, 0x909,
-    0xA0A, 0x909, 0x808, 0x808, 0x707, 0x707, 0x606, 0x505,
-    // Background gradient
-    0x000, 0x001, 0x002, 0x003, 0x004, 0x005, 0x006, 0x007,
-  };
-
   // Delay allows copperlist to be updated without fade.
   // This ensures previous fade is reflected in the second copperlist.
   if (! delay_fade) {
-    fade_common(fade_in ? g.colors : colors_lo,
-                fade_in ? colors_hi : g.colors,
-                kFadeActionNumColors, fade_in);
-  }
-
-  // Update background gradient in the copperlist.
-  // This is not otheriwse updated by gfx_update_display.
-  UWORD* cop_rows = &cop_lists[g.cop_list_back][g.cop_list_rows_start];
-
-  UWORD start_y = kDispWinY + kDrawTop;
-  UWORD stop_y = kDispWinY + kDispHeight;
-  UWORD cop_rows_offset = 19;
+    if (fade_in && (g.play_level < (kFadeNumLevels - 1))) {
+      ++ g.play_level;
+    }
+    else if ((! fade_in) && (g.play_level > 0)) {
+      -- g.play_level;
+    }
 
-  for (UWORD i = 0; i < kDrawHeight; ++ i) {
-    UWORD disp_y = i + kDispWinY + kDrawTop;
+    g.colors = g.play_levels[g.play_level];
 
-    cop_rows_offset += 20 + (disp_y == 0x100 ? 2 : 0);
-    cop_rows[cop_rows_offset] = g.colors[44 + ((kDrawTop + i) >> 5)];
+    // Lane and gradient colors changed, redraw every scanline.
+    reset_row_cache();
   }
 }
 
-static BOOL fade_common(UWORD* colors_lo,
-                        UWORD* colors_hi,
-                        UWORD num_colors,
-                        BOOL fade_in) {
-  BOOL fading = FALSE;
-
-  for (UWORD i = 0; i < num_colors; ++ i) {
-    if (colors_lo[i] != colors_hi[i]) {
-      // RGB components are incremented until reaching the target.
-      UWORD delta = colors_hi[i] - colors_lo[i];
-      UWORD incr =
-        ((delta & 0x111) >> 0) |
-        ((delta & 0x222) >> 1) |
-        ((delta & 0x444) >> 2) |
-        ((delta & 0x888) >> 3);
-
-      if (fade_in) {
-        colors_lo[i] += incr;
-      }
-      else {
-        colors_hi[i] -= incr;
+// Levels step each RGB component towards its target from black, as the
+// palette was previously faded at runtime. Fading out walks back down.
+static void make_fade_levels(UWORD* colors,
+                             UWORD num_colors,
+                             UWORD* levels) {
+  for (UWORD level = 0; level < kFadeNumLevels; ++ level) {
+    for (UWORD i = 0; i < num_colors; ++ i) {
+      UWORD color = 0;
+
+      for (UWORD shift = 0; shift < 12; shift += 4) {
+        color |= MIN(level, (colors[i] >> shift) & 0xF) << shift;
       }
 
-      fading = TRUE;
+      *(levels ++) = color;
     }
   }
-
-  return fading;
 }
 
 void gfx_clear_body() {
-  for (UWORD i = 0; i < kDispDepth; ++ i) {
-    blit_rect(&disp_planes[i][0][0], kDispStride, 0, kDrawTop,
-              NULL, 0, 0, 0, kDispStride * kBitsPerByte, kDrawHeight, FALSE);
-  }
+  blit_rect(disp_planes, kDispSlice, 0, kDrawTop * kDispDepth,
+            NULL, 0, 0, 0, kDispRowBytes * kBitsPerByte, kDrawHeight * kDispDepth, FALSE);
 }
 
-#define kNumTrackLines (ARRAY_NELEMS(near_sx))
-#define kDrawCenterX ((kDispStride * kBitsPerByte) / 2)
-
 void gfx_draw_track() {
-  gfx_clear_body();
-
-  // Screen space X near coordinates for lines making up the track.
-  WORD near_sx[] = {
-    (-kLaneWidth / 2) - (kStripeWidth / 2),      // Left lane stripe left
-    (-kLaneWidth / 2) + (kStripeWidth / 2),      // Left lane stripe right
-    ( kLaneWidth / 2) - (kStripeWidth / 2),      // Right lane stripe left
-    ( kLaneWidth / 2) + (kStripeWidth / 2),      // Right lane stripe right
-    (-(3 * kLaneWidth) / 2) - kBorderWidth,      // Left border left
-    (-(3 * kLaneWidth) / 2),                     // Left border right
-    ( (3 * kLaneWidth) / 2),                     // Right lane left
-    ( (3 * kLaneWidth) / 2) + kBorderWidth,      // Right lane right
-    -kBlockWidth / 2 - kLaneWidth,               // Left lane blocks left
-     kBlockWidth / 2 - kLaneWidth,               // Left lane blocks right
-    -kBlockWidth / 2,                            // Middle lane blocks left
-     kBlockWidth / 2,                            // Middle lane blocks right
-    -kBlockWidth / 2 + kLaneWidth,               // Right lane blocks left
-     kBlockWidth / 2 + kLaneWidth,               // Right lane blocks right
-    -kDrawCenterX,                               // Left screen edge
-     kDrawCenterX - 1,                           // Right screen edge
-    (-(3 * kLaneWidth) / 2) - kBorderWidth - 1,  // Left border edge
-    ( (3 * kLaneWidth) / 2) + kBorderWidth + 1,  // Right border edge
-  };
-
-  // Project near coordinates to far plane.
-  WORD far_sx[kNumTrackLines];
-
-  for (UWORD i = 0; i < kNumTrackLines - 2; ++ i) {
-    far_sx[i] = near_sx[i];
-
-    if (i < (kNumTrackLines - 4)) {
-      far_sx[i] /= kFarNearRatio;
-    }
-  }
-
-  // Outer border edges cannot be projected accurately, just offset from inner.
-  far_sx[kNumTrackLines - 2] = far_sx[4] - 1;
-  far_sx[kNumTrackLines - 1] = far_sx[7] + 1;
-
-  // 1 = stripe, 2 = left blocks, 3 = middle blocks, 4 = right blocks, 5 = border, 6 = background
-  UWORD colors[] = {1, 1, 1, 1, 5, 5, 5, 5, 2, 2, 3, 3, 4, 4, 6, 6, 6, 6};
-
-  for (UWORD plane_idx = 0; plane_idx < kDispDepth; ++ plane_idx) {
-    UWORD* plane = &disp_planes[plane_idx][0][0];
-
-    // Draw lines bordering filled regions in the corresponding color.
-    for (UWORD i = 0; i < ARRAY_NELEMS(near_sx); ++ i) {
-      if (colors[i] & (1 << plane_idx)) {
-        blit_line(plane, kDispStride, far_sx[i] + kDrawCenterX,
-                  kDrawTop, near_sx[i] + kDrawCenterX, kDispHeight - 1);
-      }
-    }
+  UWORD* body = &disp_planes[kDrawTop][0][0];
 
-    // Fill between the lines in each plane.
-    blit_fill(plane, kDispStride, 0, kDrawTop, kDispStride * kBitsPerByte, kDrawHeight);
+  if (g.track_planes) {
+    // Body rows are contiguous across interleaved planes, one blit covers them all.
+    blit_copy(g.track_planes, kDispSlice, 0, 0, body, kDispSlice, 0, 0,
+              kDispRowBytes * kBitsPerByte, kDrawHeight * kDispDepth, TRUE, FALSE);
+  }
+  else {
+    gfx_wait_blit();
+    unpack_track(body);
   }
 }
 
@@ -655,17 +885,22 @@ void gfx_update_display(TrackStep *step_near,
                         ULONG vu_meter_z,
                         UWORD score_frac) {
   // Work on the back (non-displayed) copperlist.
-  UWORD* cop_list = cop_lists[g.cop_list_back];
+  UWORD back = g.cop_list_back;
+  UWORD* cop_list = cop_lists[back];
   g.cop_list_back ^= 1;
 
-  // Project ball world X position into screen space.
-  WORD ball_sx = (ball_x * (kNumVisibleSteps - kNumStepsDelay)) / kNumVisibleSteps;
+  WORD ball_sx = project_ball_x(ball_x);
 
   // Camera will move a percentage of the ball position.
   WORD camera_x = (ball_sx * 74) / 100;
 
   // Sprite will move the remainder of the ball position.
   WORD sprite_x = (kDispWidth / 2) + (ball_sx - camera_x);
+  g.latch_sprite_x[back] = sprite_x - ball_sx;
+
+  // Scroll registers only need rewriting if camera X moved since this copperlist was drawn.
+  BOOL shift_changed = (camera_x != g.row_camera_x[back]);
+  g.row_camera_x[back] = camera_x;
 
   update_score(cop_list, score_frac);
   update_sprite(cop_list, sprite_x, camera_z_inc);
@@ -686,23 +921,71 @@ void gfx_update_display(TrackStep *step_near,
   // Update routine begins at near plane (bottom scanline) and advances to far (top).
   TrackStep* step = step_near;
   ULONG z_start = camera_z + kNearZ;
-  UWORD* cop_row_end = &cop_list[g.cop_list_rows_end];
 
-  // Z increment added at each scanline, step advances when exceeds kBlockGapDepth.
-  UWORD z_since_step = camera_z % kBlockGapDepth;
+  // Z increment added at each scanline, step advances when exceeds block_gap_depth.
+  UWORD z_since_step = camera_z % block_gap_depth;
 
   // Bottom segment of display, then extra wait at 0x100, then top segment.
   ULONG loop_counts =
-    ((0xFF - (kDispWinY + kDispHeight - kDrawHeight)) << 0x10) |
+    ((0xFF - (kDispWinY + kDispHeight - g.draw_height)) << 0x10) |
     (kDispWinY + kDispHeight - 1 - 0x100);
 
-  update_coplist(g.colors, cop_row_end, g.z_incs, step_near, z_since_step, shift_params,
-                 vu_meter_z, shift_err_inc, z_start, loop_counts);
+  PROFILE_PHASE(ProfilePhaseCoplist);
+  UWORD* rows_start = update_coplist(g.colors, &cop_list[g.cop_list_rows_end], g.z_incs, g.rows[back],
+                                     step_near, shift_changed, g.fetch32, z_since_step, shift_params,
+                                     vu_meter_z, shift_err_inc, z_start, loop_counts);
+
+  PROFILE_PHASE(ProfilePhaseGfx);
+
+  cop_list[g.cop_list_jump_idx + 1] = WORD_HI(rows_start);
+  cop_list[g.cop_list_jump_idx + 3] = WORD_LO(rows_start);
 
   // Bind the new copperlist for next frame.
+  g.cop_list_bound = back;
   custom.cop1lc = (ULONG)cop_list;
 }
 
+void gfx_set_ball_latch(WORD (*latch)()) {
+  // The handler may run at any point here, so it is only installed once the
+  // latch is set, and removed before the latch is cleared.
+  if (latch) {
+    // Until the next vertical blank, assume the last bound copperlist is shown.
+    g.cop_list_front = g.cop_list_bound;
+    g.ball_latch = latch;
+    system_set_level3_handler(level3_int);
+  }
+  else {
+    system_set_level3_handler(NULL);
+    g.ball_latch = NULL;
+  }
+}
+
+static void level3_int(UWORD intreq __asm("d0")) {
+  // Copper restarts from COP1LC at each vertical blank.
+  if (intreq & INTREQ_VERTB) {
+    g.cop_list_front = g.cop_list_bound;
+  }
+
+  // Sprite DMA fetched the control words at the top of the frame, so write
+  // the registers directly. They take effect from the ball's first scanline.
+  // Track shift stays as baked into the displayed copperlist.
+  if ((intreq & INTREQ_COPER) && g.ball_latch) {
+    UWORD sprite_x = g.latch_sprite_x[g.cop_list_front] + project_ball_x(g.ball_latch());
+
+    for (UWORD spr_idx = 0; spr_idx < 4; ++ spr_idx) {
+      ULONG ctl_words = ball_ctl_words(sprite_x, spr_idx);
+
+      custom.spr[spr_idx].pos = ctl_words >> kBitsPerWord;
+      custom.spr[spr_idx].ctl = ctl_words;
+    }
+  }
+}
+
+static WORD project_ball_x(WORD ball_x) {
+  // Project ball world X position into screen space.
+  return (ball_x * (g.num_visible_steps - kNumStepsDelay)) / g.num_visible_steps;
+}
+
 static void update_score(UWORD* cop_list,
                          UWORD score_frac) {
   UWORD* cl = &cop_list[g.cop_list_score_idx] + 21;
@@ -752,34 +1035,34 @@ static void update_sprite(UWORD* cop_list,
     sprite_angle = MIN(sprite_angle_bound, sprite_angle + sprite_angle_inc);
   }
 
-  // Project ball Z position to calculate screen Y position.
-  UWORD z_frac = ((kNearZ - 1) << 0x10) / kBallZ;
-  UWORD y = ((z_frac - kNearZ) * kDrawHeight) / (0x10000 - kNearZ)
-          + (kDispHeight - kDrawHeight) - (kBallEdge / 2);
-
-  // Convert screen coordinates to display coordinates, then control words.
-  UWORD hstart_left = (kDispWinX & ~1) + sprite_x - 8;
-  UWORD vstart = kDispWinY + y + (kBallEdge / 2);
-  UWORD vstop = vstart + kBallEdge;
-
-  UWORD spr_ctl_0 = (vstart & 0xFF) << SPRxPOS_SV0_SHF;
-  UWORD spr_ctl_1 = ((vstop & 0xFF) << SPRxCTL_EV0_SHF) | ((vstart >> 8) << SPRxCTL_SV8_SHF) | ((vstop >> 8) << SPRxCTL_EV8_SHF);
-
   // Update sprite control words and pointers in the copperlist.
   UWORD spr_frame = (sprite_angle + (kBallAngleLimit + 1)) >> 11;
 
   for (UWORD spr_idx = 0; spr_idx < 4; ++ spr_idx) {
     UWORD* spr = &ball_sprs[spr_frame][spr_idx][0][0];
-    UWORD hstart = hstart_left + ((spr_idx & 2) ? 8 : -8);
 
-    spr[0] = spr_ctl_0 | (((hstart >> 1) & 0xFF) << SPRxPOS_SH1_SHF);
-    spr[1] = spr_ctl_1 | ((hstart & 0x1) << SPRxCTL_SH0_SHF) | ((spr_idx & 1) << SPRxCTL_ATT_SHF);
+    *(ULONG*)spr = ball_ctl_words(sprite_x, spr_idx);
 
     cop_list[(spr_idx * 4) + 1] = WORD_HI(spr);
     cop_list[(spr_idx * 4) + 3] = WORD_LO(spr);
   }
 }
 
+static ULONG ball_ctl_words(UWORD sprite_x,
+                            UWORD spr_idx) {
+  // Convert screen coordinates to display coordinates, then control words.
+  // Sprites 0-1 are the left half of the ball, 2-3 the right.
+  UWORD hstart = (kDispWinX & ~1) + sprite_x - 8 + ((spr_idx & 2) ? 8 : -8);
+  UWORD vstart = kDispWinY + g.ball_y + (kBallEdge / 2);
+  UWORD vstop = vstart + kBallEdge;
+
+  UWORD spr_pos = ((vstart & 0xFF) << SPRxPOS_SV0_SHF) | (((hstart >> 1) & 0xFF) << SPRxPOS_SH1_SHF);
+  UWORD spr_ctl = ((vstop & 0xFF) << SPRxCTL_EV0_SHF) | ((vstart >> 8) << SPRxCTL_SV8_SHF) | ((vstop >> 8) << SPRxCTL_EV8_SHF)
+                | ((hstart & 0x1) << SPRxCTL_SH0_SHF) | ((spr_idx & 1) << SPRxCTL_ATT_SHF);
+
+  return ((ULONG)spr_pos << kBitsPerWord) | spr_ctl;
+}
+
 #define kColorCycleZShift 9
 #define kColorCycleNum 14
 
@@ -820,7 +1103,9 @@ static void update_sprite_colors(UWORD* cop_list,
 
 void gfx_wait_vblank() {
   ULONG mask = (VPOSR_V8 << 0x10) | VHPOSR_VALL;
-  ULONG compare = ((kDispWinY | 0x100) + 1) << 0x8;
+  // Line after the display window, or the last line on shorter NTSC frames.
+  UWORD line = MIN(kDispWinY + kDispHeight + 1, system_last_line());
+  ULONG compare = (ULONG)line << 0x8;
   ULONG vpos_vhpos;
 
   do {
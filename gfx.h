@@ -8,8 +8,13 @@
 #define kDispDepth 3
 #define kDispRowPadW 8 // padded for horizontal scrolling
 #define kDispColPad 1  // ^-
-#define kDispStride ((kDispWidth / kBitsPerByte) + (kDispRowPadW * kBytesPerWord))
-#define kDispSlice (kDispStride * (kDispHeight + kDispColPad))
+#define kDispRowBytes ((kDispWidth / kBitsPerByte) + (kDispRowPadW * kBytesPerWord))
+// Bitplanes are interleaved: each display row stores one line of every plane
+// back-to-back. kDispSlice steps between planes within a row, kDispStride steps
+// between rows of one plane. Blitting at kDispSlice stride with row and height
+// scaled by kDispDepth covers all planes of a rectangle in a single blit.
+#define kDispSlice kDispRowBytes
+#define kDispStride (kDispRowBytes * kDispDepth)
 #define kDispHdrHeight 52
 #define kFontWidth 5
 #define kFontHeight 5
@@ -18,9 +23,16 @@
 #define kFarNearRatio 7
 #define kFarZ 0xFFFF
 #define kNearZ (kFarZ / kFarNearRatio)
-#define kBlockGapDepth ((kFarZ - kNearZ + 1) / kNumVisibleSteps)
 #define kLaneWidth 123
 
+// Detail profiles trade draw distance against time spent updating scanlines.
+enum {
+  GfxDetailShort,  // Far scanlines left black, fewer to update
+  GfxDetailNormal,
+  GfxDetailFar,    // More steps ahead in the same depth
+  kNumGfxDetails,
+};
+
 extern Status gfx_init();
 extern void gfx_fini();
 extern UBYTE* gfx_display_planes();
@@ -31,9 +43,14 @@ extern void gfx_draw_text(STRPTR text,
                           UWORD top,
                           UWORD color,
                           BOOL replace_bg);
+extern void gfx_draw_debug_text(STRPTR text);
 extern void gfx_draw_logo();
 extern void gfx_draw_title(STRPTR title);
 extern void gfx_init_score();
+extern UWORD gfx_default_detail();
+extern void gfx_select_detail(UWORD detail);
+extern UWORD gfx_num_visible_steps();
+extern UWORD gfx_block_gap_depth();
 extern void gfx_fade_menu(BOOL fade_in);
 extern void gfx_fade_play(BOOL fade_in,
                           BOOL delay_fade);
@@ -47,6 +64,7 @@ extern void gfx_update_display(TrackStep *step_near,
                                UWORD camera_z_inc,
                                ULONG vu_meter_z,
                                UWORD score_frac);
+extern void gfx_set_ball_latch(WORD (*latch)());
 extern void gfx_wait_vblank();
 extern void gfx_wait_blit();
 extern void gfx_allow_copper_blits(BOOL allow);
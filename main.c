@@ -1,3 +1,4 @@
+#include "calib.h"
 #include "common.h"
 #include "game.h"
 #include "gfx.h"
@@ -12,7 +13,7 @@ int main() {
 
   ASSERT(common_init());
   ASSERT(system_init());
-  track_init();
+  calib_init();
   ASSERT(gfx_init());
   ASSERT(menu_init());
   game_init();
@@ -1,13 +1,15 @@
 #include "menu.h"
 #include "blit.h"
+#include "calib.h"
 #include "gfx.h"
 #include "module.h"
 #include "system.h"
+#include "track.h"
 
 #include <devices/inputevent.h>
 #include <proto/graphics.h>
 
-#define kFooterHeight 13
+#define kFooterHeight 31
 
 #define kFrameWidth 1
 #define kFramePad 4
@@ -43,6 +45,12 @@
 #define kFileInfoRight (kFrameX1 - kFrameWidth - kFramePad)
 #define kFileInfoWidth (kFileInfoRight - kFileInfoLeft + 1)
 
+#define kOptionsTop (kFrameY2 + kFrameWidth + kFramePad)
+#define kOptionsRowHeight (kFontHeight + kFramePad)
+#define kOptionsTop2 (kOptionsTop + kOptionsRowHeight)
+#define kOptionValueMaxChars 6
+#define kOptionStartLeft (kFileListLeft + (16 * kFontSpacing))
+
 #define kFramePen 1
 #define kDarkPen 2
 #define kLightPen 3
@@ -58,6 +66,22 @@ typedef struct {
   UWORD mouse_2y;
 } InputState;
 
+typedef struct {
+  STRPTR label;
+  UWORD left;
+  UWORD top;
+  void (*select)();
+  void (*format_value)(STRPTR text);
+} MenuOption;
+
+enum {
+  OptionDifficulty,
+  OptionLatency,
+  OptionStart,
+  OptionDetail,
+  kNumOptions
+};
+
 static struct InputEvent* input_handler(struct InputEvent* event_list __asm("a0"),
                                         InputState* state __asm("a1"));
 static Status refresh_file_list();
@@ -67,6 +91,7 @@ static void mouse_moved(UWORD mouse_x, UWORD mouse_y);
 static Status check_mouse_button_down_file_list(UWORD mouse_x, UWORD mouse_y);
 static void check_mouse_button_down_slider(UWORD mouse_x, UWORD mouse_y);
 static BOOL check_mouse_button_down_start_button(UWORD mouse_x, UWORD mouse_y);
+static void check_mouse_button_down_options(UWORD mouse_x, UWORD mouse_y);
 static Status file_selected();
 static void slider_move(WORD unclamped_offset);
 static void slider_step(UWORD direction);
@@ -80,6 +105,23 @@ static void redraw_file_list_highlight(UWORD entry_idx, BOOL highlighted);
 static void draw_file_list_row(dirlist_entry_t* entries, STRPTR names, UWORD row);
 static void draw_frames();
 static void draw_footer_text();
+static void draw_options();
+static void redraw_option_value(UWORD option_idx);
+static void select_difficulty();
+static void format_difficulty(STRPTR text);
+static void select_latency();
+static void format_latency(STRPTR text);
+static void select_start();
+static void format_start(STRPTR text);
+static void select_detail();
+static void format_detail(STRPTR text);
+
+static MenuOption options[kNumOptions] = {
+  [OptionDifficulty] = {"DIFFICULTY:", kFileInfoLeft, kOptionsTop, select_difficulty, format_difficulty},
+  [OptionLatency] = {"LATENCY:", kFileListLeft, kOptionsTop, select_latency, format_latency},
+  [OptionStart] = {"START:", kOptionStartLeft, kOptionsTop, select_start, format_start},
+  [OptionDetail] = {"DETAIL:", kFileInfoLeft, kOptionsTop2, select_detail, format_detail},
+};
 
 static struct {
   volatile InputState input_state;
@@ -92,6 +134,9 @@ static struct {
   UWORD slider_height;
   WORD slider_drag_start_mouse_y;
   WORD slider_drag_start_offset;
+  UWORD track_tier;
+  UWORD start_pos;
+  UWORD detail;
 } g;
 
 Status menu_init() {
@@ -101,6 +146,8 @@ Status menu_init() {
   g.fl_entry_selected = -1;
   g.slider_drag_start_mouse_y = -1;
   g.slider_drag_start_offset = -1;
+  g.track_tier = TrackTierNormal;
+  g.detail = gfx_default_detail();
   g.input_state.mouse_2x = kDispWidth;
   g.input_state.mouse_2y = kDispHeight;
   g.input_state.mouse_x = g.input_state.mouse_2x / 2;
@@ -120,6 +167,7 @@ cleanup:
 }
 
 void menu_fini() {
+  track_free();
   module_close();
   system_remove_input_handler();
 
@@ -134,12 +182,25 @@ Status menu_redraw() {
   redraw_body();
   draw_frames();
   draw_footer_text();
+  draw_options();
   system_release_blitter();
 
 cleanup:
   return status;
 }
 
+UWORD menu_track_tier() {
+  return g.track_tier;
+}
+
+UWORD menu_start_pos() {
+  return g.start_pos;
+}
+
+UWORD menu_detail() {
+  return g.detail;
+}
+
 static struct InputEvent* input_handler(struct InputEvent* event_list __asm("a0"),
                                         InputState* state __asm("a1")) {
   for (struct InputEvent* event = event_list; event; event = event->ie_NextEvent) {
@@ -267,6 +328,7 @@ static Status refresh_file_list() {
   g.slider_offset = 0;
   g.slider_height = (kSliderMaxHeight * kTableNumRows) / MAX(kTableNumRows, num_entries);
 
+  track_free();
   module_close();
 
 cleanup:
@@ -281,6 +343,7 @@ static Status mouse_button_down(UWORD mouse_x,
 
   ASSERT(check_mouse_button_down_file_list(mouse_x, mouse_y));
   check_mouse_button_down_slider(mouse_x, mouse_y);
+  check_mouse_button_down_options(mouse_x, mouse_y);
 
   if (check_mouse_button_down_start_button(mouse_x, mouse_y)) {
     status = StatusPlay;
@@ -401,6 +464,23 @@ static BOOL check_mouse_button_down_start_button(UWORD mouse_x,
   return FALSE;
 }
 
+static void check_mouse_button_down_options(UWORD mouse_x,
+                                            UWORD mouse_y) {
+  if (mouse_y > kFrameY2) {
+    for (UWORD i = 0; i < kNumOptions; ++ i) {
+      MenuOption* option = &options[i];
+      UWORD num_chars = string_length(option->label) + 1 + kOptionValueMaxChars;
+      UWORD row_top = option->top - (kFramePad / 2);
+
+      if ((mouse_x >= option->left) && (mouse_x < (option->left + (num_chars * kFontSpacing))) &&
+          (mouse_y >= row_top) && (mouse_y < (row_top + kOptionsRowHeight))) {
+        option->select();
+        redraw_option_value(i);
+      }
+    }
+  }
+}
+
 static Status file_selected() {
   Status status = StatusOK;
 
@@ -409,6 +489,8 @@ static Status file_selected() {
   dirlist_entry_t* entry = entries + g.fl_entry_selected;
   STRPTR file_name = names + entry->name_offset;
 
+  // Track was built for the previous module.
+  track_free();
   module_close();
   module_open(g.dir_path, file_name);
 
@@ -427,6 +509,10 @@ static Status file_selected() {
 
   redraw_mod_info();
 
+  // Song positions differ between modules, start from the beginning.
+  g.start_pos = 0;
+  redraw_option_value(OptionStart);
+
 cleanup:
   return status;
 }
@@ -480,12 +566,8 @@ static void redraw_path() {
   UWORD clear_width = kFrameX3 - clear_left;
   UWORD clear_height = kFrameY1 - clear_top;
 
-  for (UWORD i = 0; i < kDispDepth; ++ i) {
-    UBYTE* plane = disp_planes + (i * kDispSlice);
-
-    blit_rect(plane, kDispStride, clear_left, clear_top,
-              NULL, 0, 0, 0, clear_width, clear_height, FALSE);
-  }
+  blit_rect(disp_planes, kDispSlice, clear_left, clear_top * kDispDepth,
+            NULL, 0, 0, 0, clear_width, clear_height * kDispDepth, FALSE);
 
   STRPTR path_start = g.dir_path + MAX(0, string_length(g.dir_path) - kPathInfoMaxChars);
   gfx_draw_text(path_start, -1, kFileListLeft, kPathInfoTop, kDarkPen, TRUE);
@@ -536,19 +618,16 @@ static void redraw_file_list(BOOL force_redraw) {
   UWORD redraw_left = kFrameX1 + kFrameWidth;
   UWORD redraw_width = kFrameX2 - redraw_left;
 
-  for (UWORD i = 0; i < kDispDepth; ++ i) {
-    UBYTE* plane = planes + (i * kDispSlice);
-
-    if (copy_height > 0) {
-      blit_copy(plane, kDispStride, redraw_left, copy_from_top,
-                plane, kDispStride, redraw_left, copy_to_top,
-                redraw_width, copy_height, TRUE, (copy_from_top < copy_to_top));
-    }
-
-    blit_rect(plane, kDispStride, redraw_left, clear_top,
-              NULL, 0, 0, 0, redraw_width, clear_height, FALSE);
+  // Scroll and clear all interleaved planes with one blit each.
+  if (copy_height > 0) {
+    blit_copy(planes, kDispSlice, redraw_left, copy_from_top * kDispDepth,
+              planes, kDispSlice, redraw_left, copy_to_top * kDispDepth,
+              redraw_width, copy_height * kDispDepth, TRUE, (copy_from_top < copy_to_top));
   }
 
+  blit_rect(planes, kDispSlice, redraw_left, clear_top * kDispDepth,
+            NULL, 0, 0, 0, redraw_width, clear_height * kDispDepth, FALSE);
+
   dirlist_entry_t* entries = dirlist_entries(&g.file_list);
   STRPTR names = dirlist_names(&g.file_list);
 
@@ -738,3 +817,72 @@ static void draw_footer_text() {
 
   gfx_draw_text(text, -1, left, top, kLightPen, TRUE);
 }
+
+static void draw_options() {
+  for (UWORD i = 0; i < kNumOptions; ++ i) {
+    gfx_draw_text(options[i].label, -1, options[i].left, options[i].top, kDarkPen, TRUE);
+    redraw_option_value(i);
+  }
+}
+
+static void redraw_option_value(UWORD option_idx) {
+  MenuOption* option = &options[option_idx];
+  UBYTE* planes = gfx_display_planes();
+  UWORD left = option->left + ((string_length(option->label) + 1) * kFontSpacing);
+
+  blit_rect(planes, kDispSlice, left, option->top * kDispDepth,
+            NULL, 0, 0, 0, kOptionValueMaxChars * kFontSpacing, kFontHeight * kDispDepth, FALSE);
+
+  BYTE value_text[kOptionValueMaxChars + 1];
+  option->format_value(value_text);
+  gfx_draw_text(value_text, kOptionValueMaxChars, left, option->top, kLightPen, TRUE);
+}
+
+static void select_difficulty() {
+  g.track_tier = (g.track_tier + 1) % kNumTrackTiers;
+}
+
+static void format_difficulty(STRPTR text) {
+  static STRPTR tier_names[kNumTrackTiers] = {"EASY", "NORMAL", "HARD"};
+  string_copy(text, tier_names[g.track_tier]);
+}
+
+static void select_latency() {
+  menu_redraw_button("TAP ALONG TO CLICKS");
+
+  // Save outside of blitter ownership, floppy access may need the blitter.
+  if (calib_run() == StatusOK) {
+    system_release_blitter();
+    calib_save();
+    system_acquire_blitter();
+  }
+
+  // Button release was not seen by the input handler while calibrating.
+  g.input_state.mouse_pressed = FALSE;
+
+  menu_redraw_button(module_is_open() ? "START GAME" : NULL);
+}
+
+static void format_latency(STRPTR text) {
+  string_from_uword(text, calib_latency_millis());
+  string_copy(text + string_length(text), "MS");
+}
+
+static void select_start() {
+  // Cycle through song positions for practice, wrapping to the beginning.
+  UWORD num_positions = module_is_open() ? module_header()->pat_tbl_size : 0;
+  g.start_pos = (g.start_pos + 1 < num_positions) ? (g.start_pos + 1) : 0;
+}
+
+static void format_start(STRPTR text) {
+  string_from_uword(text, g.start_pos);
+}
+
+static void select_detail() {
+  g.detail = (g.detail + 1) % kNumGfxDetails;
+}
+
+static void format_detail(STRPTR text) {
+  static STRPTR detail_names[kNumGfxDetails] = {"SHORT", "NORMAL", "FAR"};
+  string_copy(text, detail_names[g.detail]);
+}
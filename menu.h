@@ -7,3 +7,6 @@ extern void menu_fini();
 extern Status menu_redraw();
 extern Status menu_event_loop();
 extern void menu_redraw_button(STRPTR text);
+extern UWORD menu_track_tier();
+extern UWORD menu_start_pos();
+extern UWORD menu_detail();
@@ -0,0 +1,114 @@
+#include "profile.h"
+#include "custom.h"
+#include "system.h"
+
+#ifdef MS_PROFILE
+
+#define kColorClocksPerLine 227
+#define kPhaseNone kNumProfilePhases
+
+static ULONG elapsed_clocks(ULONG beam_start,
+                            ULONG beam_end);
+
+// Raster bar color for each phase, shown in the border and header background.
+static UWORD phase_colors[kNumProfilePhases] = {
+  0xF00, 0xF80, 0xFF0, 0x0F0, 0x0FF, 0x00F, 0xF0F, 0xFFF,
+};
+
+static STRPTR phase_names[kNumProfilePhases] = {
+  "steps", "camera", "input", "collision", "fade", "gfx", "coplist", "other",
+};
+
+static struct {
+  UWORD phase;
+  ULONG phase_beam;                          // VPOSR/VHPOSR when the phase began
+  ULONG frame_clocks[kNumProfilePhases];     // Summed over this frame, phases may resume
+  ULONG min_clocks[kNumProfilePhases];
+  ULONG max_clocks[kNumProfilePhases];
+  ULONG sum_clocks[kNumProfilePhases];
+  UWORD num_frames;
+} g;
+
+void profile_reset() {
+  memory_clear(&g, sizeof(g));
+  g.phase = kPhaseNone;
+
+  for (UWORD i = 0; i < kNumProfilePhases; ++ i) {
+    g.min_clocks[i] = ~0;
+  }
+}
+
+void profile_phase(UWORD phase) {
+  ULONG beam = *(volatile ULONG*)&custom.vposr;
+
+  // Show the phase as a raster bar from here.
+  custom.color[0] = phase_colors[phase];
+
+  if (g.phase != kPhaseNone) {
+    g.frame_clocks[g.phase] += elapsed_clocks(g.phase_beam, beam);
+  }
+
+  g.phase = phase;
+  g.phase_beam = beam;
+}
+
+void profile_end_frame() {
+  ULONG beam = *(volatile ULONG*)&custom.vposr;
+
+  custom.color[0] = 0;
+
+  if (g.phase != kPhaseNone) {
+    g.frame_clocks[g.phase] += elapsed_clocks(g.phase_beam, beam);
+    g.phase = kPhaseNone;
+  }
+
+  for (UWORD i = 0; i < kNumProfilePhases; ++ i) {
+    ULONG clocks = g.frame_clocks[i];
+
+    g.min_clocks[i] = MIN(g.min_clocks[i], clocks);
+    g.max_clocks[i] = MAX(g.max_clocks[i], clocks);
+    g.sum_clocks[i] += clocks;
+    g.frame_clocks[i] = 0;
+  }
+
+  ++ g.num_frames;
+}
+
+void profile_print() {
+  BYTE line[0x40];
+
+  system_print("loop profile, color clocks min/avg/max:\n");
+
+  for (UWORD i = 0; (i < kNumProfilePhases) && g.num_frames; ++ i) {
+    ULONG values[] = {g.min_clocks[i], g.sum_clocks[i] / g.num_frames, g.max_clocks[i]};
+    STRPTR text = line;
+
+    string_copy(text, phase_names[i]);
+    text += string_length(text);
+
+    for (UWORD j = 0; j < ARRAY_NELEMS(values); ++ j) {
+      string_copy(text, (j == 0) ? ": " : "/");
+      text += string_length(text);
+      string_from_ulong(text, values[j]);
+      text += string_length(text);
+    }
+
+    string_copy(text, "\n");
+    system_print(line);
+  }
+}
+
+static ULONG elapsed_clocks(ULONG beam_start,
+                            ULONG beam_end) {
+  // Lines from the 9-bit vertical position, wrapping once at the end of a frame.
+  WORD lines = ((beam_end >> 8) & 0x1FF) - ((beam_start >> 8) & 0x1FF);
+  WORD clocks = (beam_end & 0xFF) - (beam_start & 0xFF);
+
+  if ((lines < 0) || ((lines == 0) && (clocks < 0))) {
+    lines += system_last_line() + 1;
+  }
+
+  return ((ULONG)lines * kColorClocksPerLine) + clocks;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "common.h"
+
+// Game loop phases, timed in color clocks by make PROFILE=1.
+enum {
+  ProfilePhaseSteps,
+  ProfilePhaseCamera,
+  ProfilePhaseInput,
+  ProfilePhaseCollision,
+  ProfilePhaseFade,
+  ProfilePhaseGfx,
+  ProfilePhaseCoplist,
+  ProfilePhaseOther,
+  kNumProfilePhases,
+};
+
+#ifdef MS_PROFILE
+#define PROFILE_RESET() profile_reset()
+#define PROFILE_PHASE(PHASE) profile_phase(PHASE)
+#define PROFILE_END_FRAME() profile_end_frame()
+#else
+#define PROFILE_RESET()
+#define PROFILE_PHASE(PHASE)
+#define PROFILE_END_FRAME()
+#endif
+
+extern void profile_reset();
+extern void profile_phase(UWORD phase);
+extern void profile_end_frame();
+extern void profile_print();
@@ -160,12 +160,34 @@ n_sfxpri	rs.b	1
 n_freecnt	rs.b	1
 n_musiconly	rs.b	1
 	ifd	MODSURFER
+n_ms_voltab	rs.l	1		; master volume table, zero for a suppressed note
+n_ms_dmatime	rs.l	1		; tick clock when DMA started the current note
 n_ms_lastsample	rs.b	1		; last sample played on channel, for suppression
+n_ms_suppress	rs.b	1		; number (1-31) of next sample to play at zero volume
+n_ms_mute	rs.b	1		; boolean to play current note at zero volume
 n_pad		rs.b	1		; align data structure to word boundary
 	endc
 n_sizeof	rs.b	0
 
 
+	ifd	MODSURFER
+; Row event, pushed into a ring buffer for the game at the start of each row
+ms_NumRowEvents	equ	16		; power of two, must match ptplayer.h
+	ifd	MS_PROFILE
+ms_NumProfBuckets equ	32		; must match ptplayer.h
+	endc
+
+		rsreset
+re_Time		rs.l	1		; ms_TickTime at the start of the row
+re_Ticks	rs.l	1		; length of the row in CIA ticks
+re_SongPos	rs.b	1
+re_Row		rs.b	1
+re_Speed	rs.b	1		; ticks per row
+re_Tempo	rs.b	1		; beats per minute
+re_sizeof	rs.b	0
+	endc
+
+
 	ifd	SDATA
 	xref	_LinkerDB		; small data base from linker
 	near	a4
@@ -225,6 +247,12 @@ _mt_install_cia:
 
 	; load TimerA in continuous mode for the default tempo of 125
 	divu	#125,d0
+	ifd	MODSURFER
+	; timer is loaded immediately, restart the tick clock
+	move.w	d0,ms_TimerPeriod(a4)
+	move.w	d0,ms_TimerLoad(a4)
+	clr.l	ms_TickTime(a4)
+	endc
 	move.b	d0,CIATALO(a0)
 	lsr.w	#8,d0
 	move.b	d0,CIATAHI(a0)
@@ -307,11 +335,30 @@ mt_TimerAInt:
 	btst	#0,CIAB+CIAICR
 	beq	.2
 
+	ifd	MODSURFER
+	; advance the CIA tick clock by the interval which just elapsed
+	; the latched period was reloaded into the timer at this underflow
+	moveq	#0,d0
+	move.w	ms_TimerLoad(a4),d0
+	add.l	d0,ms_TickTime(a4)
+	move.w	ms_TimerPeriod(a4),ms_TimerLoad(a4)
+	endc
+
 	; it was a TA interrupt, do music when enabled
 	tst.b	mt_Enable(a4)
 	beq	.1
 
+	ifd	MS_PROFILE
+	move.l	VPOSR(a6),-(sp)		; beam position before replay
+	endc
+
 	bsr	_mt_music		; music with sfx inserted
+
+	ifd	MS_PROFILE
+	move.l	(sp)+,d1
+	bsr	ms_profile
+	endc
+
 	movem.l	(sp)+,d0-d7/a0-a6
 	nop
 	rte
@@ -322,6 +369,52 @@ mt_TimerAInt:
 	rte
 
 
+	ifd	MS_PROFILE
+;---------------------------------------------------------------------------
+ms_profile:
+; Count the color clocks spent in one replay into a histogram.
+; Replays during which the beam wrapped to a new frame are not counted.
+; a6 = CUSTOM
+; d1.l = VPOSR/VHPOSR sampled before the replay
+
+	move.l	VPOSR(a6),d0
+
+	; horizontal positions elapsed, may be negative
+	moveq	#0,d2
+	move.b	d0,d2
+	moveq	#0,d3
+	move.b	d1,d3
+	sub.w	d3,d2
+
+	; lines elapsed
+	lsr.l	#8,d0
+	and.w	#$1ff,d0
+	lsr.l	#8,d1
+	and.w	#$1ff,d1
+	sub.w	d1,d0
+	bmi	.3
+
+	mulu	#227,d0			; color clocks per line, over a word past 288 lines
+	ext.l	d2
+	add.l	d2,d0
+
+	cmp.l	ms_ProfMax(a4),d0
+	bls	.1
+	move.l	d0,ms_ProfMax(a4)
+
+.1:	lsr.l	#8,d0
+	cmp.l	#ms_NumProfBuckets-1,d0
+	bls	.2
+	moveq	#ms_NumProfBuckets-1,d0
+.2:	add.w	d0,d0
+	lea	ms_ProfHist(a4),a0
+	addq.w	#1,(a0,d0.w)
+	bne	.3
+	subq.w	#1,(a0,d0.w)		; saturate
+.3:	rts
+	endc
+
+
 ;---------------------------------------------------------------------------
 mt_TimerBdmaon:
 ; One-shot TimerB interrupt to enable audio DMA after 496 ticks.
@@ -468,6 +561,10 @@ _mt_init:
 	; reset CIA timer A to default (125)
 	move.l	mt_timerval(a4),d0
 	divu	#125,d0
+	ifd	MODSURFER
+	; latched period is loaded at the next underflow
+	move.w	d0,ms_TimerPeriod(a4)
+	endc
 	move.b	d0,CIAB+CIATALO
 	lsr.w	#8,d0
 	move.b	d0,CIAB+CIATAHI
@@ -518,10 +615,29 @@ mt_reset:
 	clr.b	mt_E8Trigger(a4)
 
 	ifd	MODSURFER
-	; reset processed steps, number of rows to wait, BPM
-	clr.b	ms_StepCount(a4)
+	; reset number of rows to wait, BPM, suppressed samples
+	; row events and tick clock run on, the game resyncs to ms_RowHead
 	clr.b	ms_HoldRows(a4)
 	move.b	#125,ms_BeatsPerMin(a4)
+	moveq	#0,d0
+	move.l	d0,mt_chan1+n_ms_lastsample(a4)
+	move.l	d0,mt_chan2+n_ms_lastsample(a4)
+	move.l	d0,mt_chan3+n_ms_lastsample(a4)
+	move.l	d0,mt_chan4+n_ms_lastsample(a4)
+	move.l	mt_MasterVolTab(a4),a0
+	move.l	a0,mt_chan1+n_ms_voltab(a4)
+	move.l	a0,mt_chan2+n_ms_voltab(a4)
+	move.l	a0,mt_chan3+n_ms_voltab(a4)
+	move.l	a0,mt_chan4+n_ms_voltab(a4)
+	endc
+
+	ifd	MS_PROFILE
+	; start a new replay profile
+	clr.l	ms_ProfMax(a4)
+	lea	ms_ProfHist(a4),a0
+	moveq	#ms_NumProfBuckets-1,d0
+.prof:	clr.w	(a0)+
+	dbf	d0,.prof
 	endc
 
 	ifnd	SDATA
@@ -918,9 +1034,297 @@ _mt_mastervol:
 	lea	mt_data+mt_MasterVolTab(pc),a1
 	move.l	a0,(a1)
 	endc
+
+	ifd	MODSURFER
+	; channels playing a suppressed note stay at zero volume
+	ifd	SDATA
+	lea	mt_chan1(a4),a1
+	else
+	lea	mt_data+mt_chan1(pc),a1
+	endc
+	moveq	#4-1,d0
+.1:	tst.b	n_ms_mute(a1)
+	bne	.2
+	move.l	a0,n_ms_voltab(a1)
+.2:	lea	n_sizeof(a1),a1
+	dbf	d0,.1
+	endc
+
+	move.w	#$c000,INTENA(a6)
+
+	rts
+
+
+	ifd	MODSURFER
+;---------------------------------------------------------------------------
+	xdef	_ms_suppress
+_ms_suppress:
+; Play the next note of a sample on one channel at zero volume.
+; The note already playing on the channel is unaffected.
+; a6 = CUSTOM
+; d0.w = channel (0-3)
+; d1.b = sample number (1-31), or 0 to play all notes normally
+
+	ifnd	SDATA
+	move.l	a4,-(sp)
+	lea	mt_data(pc),a4
+	endc
+
+	mulu	#n_sizeof,d0
+	lea	mt_chan1(a4),a0
+	add.w	d0,a0
+	move.b	d1,n_ms_suppress(a0)
+
+	ifnd	SDATA
+	move.l	(sp)+,a4
+	endc
+	rts
+
+
+;---------------------------------------------------------------------------
+	xdef	_ms_unmute
+_ms_unmute:
+; Restore the volume of a note played at zero volume on one channel.
+; a6 = CUSTOM
+; d0.w = channel (0-3)
+
+	ifnd	SDATA
+	move.l	a4,-(sp)
+	lea	mt_data(pc),a4
+	endc
+
+	mulu	#n_sizeof,d0
+	lea	mt_chan1(a4),a0
+	add.w	d0,a0
+
+	move.w	#$4000,INTENA(a6)
+
+	tst.b	n_ms_mute(a0)
+	beq	.1
+	clr.b	n_ms_mute(a0)
+	move.l	mt_MasterVolTab(a4),a1
+	move.l	a1,n_ms_voltab(a0)
+
+	; leave volume alone while a sound effect owns the channel
+	tst.b	n_sfxpri(a0)
+	bne	.1
+	move.w	n_volume(a0),d0
+	moveq	#0,d1
+	move.b	(a1,d0.w),d1
+	move.w	n_audreg(a0),d0
+	move.w	d1,AUDVOL(a6,d0.w)
+
+.1:	move.w	#$c000,INTENA(a6)
+
+	ifnd	SDATA
+	move.l	(sp)+,a4
+	endc
+	rts
+
+
+;---------------------------------------------------------------------------
+	xdef	_ms_pause
+_ms_pause:
+; Freeze the replay and silence all music channels.
+; The CIA tick clock keeps running.
+; a6 = CUSTOM
+
+	ifnd	SDATA
+	move.l	a4,-(sp)
+	lea	mt_data(pc),a4
+	endc
+
+	clr.b	mt_Enable(a4)
+
+	; Let a pending TimerB chain enable DMA and set the repeat samples
+	; first (at most 2x496 ticks). Stopped before it, the chain would still
+	; load the repeats and new notes would resume without their start.
+	; No new chain is armed once the replay is disabled.
+	move.l	mt_Lev6Int(pc),a0
+	lea	mt_TimerAInt(pc),a1
+.wait:	cmp.l	(a0),a1
+	bne	.wait
+
+	move.w	#$4000,INTENA(a6)
+
+	; remember playing channels
+	moveq	#$f,d0
+	and.w	DMACONR(a6),d0
+	move.w	d0,ms_PauseDma(a4)
+	move.w	d0,DMACON(a6)
+	move.l	ms_TickTime(a4),ms_PauseTime(a4)
+
+	move.w	#$c000,INTENA(a6)
+
+	ifnd	SDATA
+	move.l	(sp)+,a4
+	endc
+	rts
+
+
+;---------------------------------------------------------------------------
+	xdef	_ms_resume
+_ms_resume:
+; Continue the replay from the tick at which it was frozen. Channels
+; stopped by _ms_pause restart where they would be now, had the replay
+; only been delayed. The position in the sample follows from the ticks
+; since the channel's DMA started and its period, so looping samples
+; come back in phase. One-shot samples that have ended stay silent.
+; a6 = CUSTOM
+; d0.l = tick clock now
+; -> d0.l = CIA ticks by which the replay was delayed
+
+	movem.l	d2-d6/a2,-(sp)
+	ifnd	SDATA
+	move.l	a4,-(sp)
+	lea	mt_data(pc),a4
+	endc
+
+	move.w	#$4000,INTENA(a6)
+
+	; whole timer periods skipped, next interrupt plays the frozen tick
+	move.l	ms_TickTime(a4),d5
+	sub.l	ms_PauseTime(a4),d5
+
+	; now on the timeline of the replay before the pause
+	move.l	d0,d4
+	sub.l	d5,d4
+
+	moveq	#0,d6			; d6 channels restarted
+	lea	mt_chan1(a4),a2
+	lea	mt_chan4+n_sizeof(a4),a1
+
+.chan:	move.w	n_dmabit(a2),d0
+	and.w	ms_PauseDma(a4),d0
+	beq	.next
+	move.w	n_period(a2),d2
+	beq	.next
+
+	; words played since DMA started, one byte every period color clocks,
+	; which are 5 per CIA tick
+	move.l	d4,d1
+	sub.l	n_ms_dmatime(a2),d1
+	bpl	.1
+	moveq	#0,d1
+.1:	cmp.l	#$33333333,d1
+	bls	.2
+	move.l	#$33333333,d1
+.2:	move.l	d1,d3
+	add.l	d1,d1
+	add.l	d1,d1
+	add.l	d3,d1
+	add.w	d2,d2
+	bsr	ms_divu32
+
+	moveq	#0,d0
+	move.w	n_length(a2),d0
+	move.l	n_start(a2),a0
+	cmp.l	d0,d1
+	blo	.3
+
+	; past the sample start, continue within the repeat
+	sub.l	d0,d1
+	move.w	n_replen(a2),d2
+	cmp.w	#1,d2
+	bls	.next			; one-shot has ended
+	bsr	ms_divu32
+	move.w	d2,d0
+	moveq	#0,d1
+	move.w	d3,d1
+	move.l	n_loopstart(a2),a0
+
+	; d0.w = length, d1.l = words into it
+.3:	sub.w	d1,d0
+	add.l	d1,d1
+	add.l	d1,a0
+	move.w	n_audreg(a2),d1
+	move.l	a0,AUDLC(a6,d1.w)
+	move.w	d0,AUDLEN(a6,d1.w)
+	or.w	n_dmabit(a2),d6
+
+	; note start on the delayed timeline, for a further pause
+	add.l	d5,n_ms_dmatime(a2)
+
+.next:	lea	n_sizeof(a2),a2
+	cmp.l	a1,a2
+	blo	.chan
+
+	; Paula raises a channel's audio interrupt flag when it latches the
+	; pointer and length at the start of DMA
+	move.w	d6,d0
+	lsl.w	#7,d0
+	move.w	d0,INTREQ(a6)
+	move.w	d6,d1
+	or.w	#$8000,d1
+	move.w	d1,DMACON(a6)
+.wait:	move.w	INTREQR(a6),d1
+	and.w	d0,d1
+	cmp.w	d0,d1
+	bne	.wait
+	move.w	d0,INTREQ(a6)
+
+	; then set the repeat, as the TimerB interrupt does for a new note
+	lea	mt_chan1(a4),a2
+.rep:	move.w	n_dmabit(a2),d0
+	and.w	d6,d0
+	beq	.4
+	move.w	n_audreg(a2),d0
+	move.l	n_loopstart(a2),AUDLC(a6,d0.w)
+	move.w	n_replen(a2),AUDLEN(a6,d0.w)
+.4:	lea	n_sizeof(a2),a2
+	cmp.l	a1,a2
+	blo	.rep
+
+	st	mt_Enable(a4)
+	move.l	d5,d0
+
+	move.w	#$c000,INTENA(a6)
+
+	ifnd	SDATA
+	move.l	(sp)+,a4
+	endc
+	movem.l	(sp)+,d2-d6/a2
+	rts
+
+
+ms_divu32:
+; Unsigned division of a long by a word, with a long quotient.
+; d1.l = dividend
+; d2.w = divisor
+; -> d1.l = quotient
+; -> d3.w = remainder
+
+	moveq	#0,d3
+	swap	d1
+	move.w	d1,d3
+	divu	d2,d3			; d3 = remainder:quotient of high word
+	move.w	d3,d1
+	swap	d1			; d1 = high quotient:low word
+	move.w	d1,d3
+	divu	d2,d3			; d3 = remainder:quotient of low word
+	move.w	d3,d1
+	swap	d3
+	rts
+	endc
+
+	move.w	#$4000,INTENA(a6)
+
+	move.w	ms_PauseDma(a4),d0
+	or.w	#$8000,d0
+	move.w	d0,DMACON(a6)
+	st	mt_Enable(a4)
+
+	; whole timer periods skipped, next interrupt plays the frozen tick
+	move.l	ms_TickTime(a4),d0
+	sub.l	ms_PauseTime(a4),d0
+
 	move.w	#$c000,INTENA(a6)
 
+	ifnd	SDATA
+	move.l	(sp)+,a4
+	endc
 	rts
+	endc
 
 
 ;---------------------------------------------------------------------------
@@ -946,14 +1350,23 @@ _mt_music:
 	move.b	d7,mt_Counter(a4)
 
 	ifd	MODSURFER
-	; announce new row for game to synchronize with
-	addq.b	#1,ms_StepCount(a4)
+	; push a timestamped row event for the game to synchronize with
+	moveq	#ms_NumRowEvents-1,d1
+	and.b	ms_RowHead(a4),d1
+	mulu	#re_sizeof,d1
+	lea	ms_RowEvents(a4),a0
+	add.w	d1,a0
+	move.l	ms_TickTime(a4),re_Time(a0)
+	move.b	mt_SongPos(a4),re_SongPos(a0)
+	move.w	mt_PatternPos(a4),d1
+	lsr.w	#4,d1
+	move.b	d1,re_Row(a0)
 
 	; stop processing if asked to wait one or more rows
 	cmp.b	#0,ms_HoldRows(a4)
 	beq	.no_hold_row
 	subq.b	#1,ms_HoldRows(a4)
-	rts
+	bra	ms_end_row
 .no_hold_row:
 	endc
 
@@ -998,6 +1411,10 @@ no_new_note:
 	lea	mt_TimerBdmaon(pc),a1
 	move.l	a1,(a0)
 	move.b	#$19,CIAB+CIACRB	; load/start timer B, one-shot
+
+	ifd	MODSURFER
+	bsr	ms_dma_times
+	endc
 	bra	same_pattern
 
 get_new_note:
@@ -1029,6 +1446,10 @@ get_new_note:
 	bsr	mt_playvoice
 
 settb_step:
+	ifd	MODSURFER
+	bsr	ms_end_row
+	endc
+
 	; set one-shot TimerB interrupt for enabling DMA, when needed
 	move.b	mt_dmaon+1(pc),d0
 	beq	pattern_step
@@ -1038,6 +1459,10 @@ settb_step:
 	move.l	a1,(a0)
 	move.b	#$19,CIAB+CIACRB	; load/start timer B, one-shot
 
+	ifd	MODSURFER
+	bsr	ms_dma_times
+	endc
+
 pattern_step:
 	; next pattern line, handle delay and break
 	clr.b	mt_SilCntValid(a4)	; recalculate silence counters
@@ -1088,6 +1513,55 @@ same_pattern:
 	bne	song_step
 	rts
 
+	ifd	MODSURFER
+ms_end_row:
+; Complete the row event begun at the start of the row and publish it.
+; Speed and tempo are read after the row's Fxx commands were applied.
+; a4 = mt_data
+
+	moveq	#ms_NumRowEvents-1,d0
+	and.b	ms_RowHead(a4),d0
+	mulu	#re_sizeof,d0
+	lea	ms_RowEvents(a4),a0
+	add.w	d0,a0
+	move.b	ms_BeatsPerMin(a4),re_Tempo(a0)
+
+	; the first tick runs at the timer load of the previous tempo,
+	; the remaining ticks at the period written by this row's Fxx
+	moveq	#0,d1
+	move.b	mt_Speed(a4),d1
+	move.b	d1,re_Speed(a0)
+	beq	.1			; stopped by F00, no length
+	subq.w	#1,d1
+	mulu	ms_TimerPeriod(a4),d1
+	moveq	#0,d0
+	move.w	ms_TimerLoad(a4),d0
+	add.l	d0,d1
+.1:	move.l	d1,re_Ticks(a0)
+
+	; publish only after the event is complete, the game reads without locking
+	addq.b	#1,ms_RowHead(a4)
+	rts
+
+
+ms_dma_times:
+; Remember when the armed TimerB interrupt starts DMA for new notes,
+; so _ms_resume can find where in its sample each channel is.
+; a4 = mt_data
+; d0.b = channels in mt_dmaon
+
+	move.l	ms_TickTime(a4),d1
+	add.l	#496,d1			; TimerB delay, see mt_install_cia
+	lea	mt_chan1+n_ms_dmatime(a4),a0
+.1:	lsr.b	#1,d0
+	bcc	.2
+	move.l	d1,(a0)
+.2:	lea	n_sizeof(a0),a0
+	tst.b	d0
+	bne	.1
+	rts
+	endc
+
 
 ;---------------------------------------------------------------------------
 mt_sfxonly:
@@ -1308,15 +1782,20 @@ mt_playvoice:
 	move.b	d0,d1
 	bne	.3a
 	move.b	n_ms_lastsample(a2),d1
-	jmp	.3b
+	bra	.3b
 .3a:
 	; track this sample in case it's repeated and we need to suppress it
 	; otherwise we have no sample number to match with the game's request
 	move.b	d1,n_ms_lastsample(a2)
 .3b:
 	; play next note at zero volume if the game suppressed this sample
-	cmp.b	ms_SuppressSample(a4),d1
-	seq.b	ms_SuppressNext(a4)
+	; volume paths read the channel's table, so need no checks of their own
+	move.l	mt_MasterVolTab(a4),a0
+	cmp.b	n_ms_suppress(a2),d1
+	seq	n_ms_mute(a2)
+	bne	.3c
+	lea	MasterVolTab0(pc),a0
+.3c:	move.l	a0,n_ms_voltab(a2)
 	endc
 
 	and.w	#$0fff,d6		; d6 note
@@ -1381,16 +1860,12 @@ set_loop:
 	move.l	d2,n_loopstart(a2)
 	move.l	d2,n_wavestart(a2)
 
-	move.l	mt_MasterVolTab(a4),a0
-	move.b	(a0,d1.w),d1
-
 	ifd	MODSURFER
-	; set volume to zero if game suppressed sample
-	tst.b	ms_SuppressNext(a4)
-	beq	.no_suppress
-	moveq	#0,d1
-.no_suppress:
+	move.l	n_ms_voltab(a2),a0
+	else
+	move.l	mt_MasterVolTab(a4),a0
 	endc
+	move.b	(a0,d1.w),d1
 
 	move.w	d1,AUDVOL(a5)
 
@@ -1837,16 +2312,12 @@ mt_tremolo:
 	bls	.11
 	moveq	#64,d0
 .11:	move.w	n_period(a2),AUDPER(a5)
-	move.l	mt_MasterVolTab(a4),a0
-	move.b	(a0,d0.w),d0
-
 	ifd	MODSURFER
-	; set volume to zero if game suppressed sample
-	tst.b	ms_SuppressNext(a4)
-	beq	.no_suppress
-	moveq	#0,d0
-.no_suppress:
+	move.l	n_ms_voltab(a2),a0
+	else
+	move.l	mt_MasterVolTab(a4),a0
 	endc
+	move.b	(a0,d0.w),d0
 
 	move.w	d0,AUDVOL(a5)
 
@@ -1882,16 +2353,12 @@ vol_slide_down:
 set_vol:
 	move.w	d0,n_volume(a2)
 	move.w	n_period(a2),AUDPER(a5)
-	move.l	mt_MasterVolTab(a4),a0
-	move.b	(a0,d0.w),d0
-
 	ifd	MODSURFER
-	; set volume to zero if game suppressed sample
-	tst.b	ms_SuppressNext(a4)
-	beq	.no_suppress
-	moveq	#0,d0
-.no_suppress:
+	move.l	n_ms_voltab(a2),a0
+	else
+	move.l	mt_MasterVolTab(a4),a0
 	endc
+	move.b	(a0,d0.w),d0
 
 	move.w	d0,AUDVOL(a5)
 	rts
@@ -1919,16 +2386,12 @@ mt_volchange:
 	bls	.1
 	moveq	#64,d4
 .1:	move.w	d4,n_volume(a2)
-	move.l	mt_MasterVolTab(a4),a0
-	move.b	(a0,d4.w),d4
-
 	ifd	MODSURFER
-	; set volume to zero if game suppressed sample
-	tst.b	ms_SuppressNext(a4)
-	beq	.no_suppress
-	moveq	#0,d4
-.no_suppress:
+	move.l	n_ms_voltab(a2),a0
+	else
+	move.l	mt_MasterVolTab(a4),a0
 	endc
+	move.b	(a0,d4.w),d4
 
 	move.w	d4,AUDVOL(a5)
 	rts
@@ -1969,12 +2432,16 @@ mt_setspeed:
 .1:	and.w	#$00ff,d4
 	move.l	mt_timerval(a4),d0
 	divu	d4,d0
+	ifd	MODSURFER
+	; latched period is loaded at the next underflow
+	move.w	d0,ms_TimerPeriod(a4)
+	endc
 	move.b	d0,CIAB+CIATALO
 	lsr.w	#8,d0
 	move.b	d0,CIAB+CIATAHI
 
 	ifd	MODSURFER
-	; track BPM for world Z per second calculation
+	; track BPM for row events
 	move.b	d4,ms_BeatsPerMin(a4)
 	endc
 
@@ -2199,15 +2666,6 @@ mt_notecut:
 	cmp.b	mt_Counter(a4),d0
 	bne	.1
 	move.w	d7,n_volume(a2)
-
-	ifd	MODSURFER
-	; set volume to zero if game suppressed sample
-	tst.b	ms_SuppressNext(a4)
-	beq	.no_suppress
-	moveq	#0,d7
-.no_suppress:
-	endc
-
 	move.w	d7,AUDVOL(a5)
 .1:	rts
 
@@ -2269,26 +2727,6 @@ mt_updatefunk:
 
 .2:	rts
 
-	ifd MODSURFER
-	xdef _ms_camera_z_inc
-_ms_camera_z_inc:
-	; calculate Z increment per frame for current BPM and ticks/div
-	; camera_z_inc = (kBlockGapDepth * ms_BeatsPerMin) / (125 * mt_Speed)
-	; d0 = kBlockGapDepth
-	lea	mt_data(pc),a0
-	moveq	#0,d1
-	move.b	ms_BeatsPerMin(a0),d1
-	mulu.w	d1,d0
-	move.b	mt_Speed(a0),d1
-	bne	.speed_not_zero
-	moveq	#0,d0
-	rts
-.speed_not_zero:
-	mulu.w	#125,d1
-	divu.w	d1,d0
-	rts
-	endc
-
 mt_FunkTable:
 	dc.b	0,5,6,7,8,10,11,13,16,19,22,26,32,43,64,128
 
@@ -3055,11 +3493,20 @@ mt_E8Trigger	rs.b	1		; exported as _mt_E8Trigger
 mt_MusicChannels rs.b	1		; exported as _mt_MusicChannels
 
 	ifd	MODSURFER
-ms_StepCount	rs.b	1		; number of unprocessed rows for game to handle
 ms_HoldRows	rs.b	1		; number of rows to wait before playing a new one
-ms_SuppressSample rs.b	1		; number (1-31) of next sample to play at zero volume
-ms_SuppressNext	rs.b	1		; boolean to suppress next sample played on this channel
 ms_BeatsPerMin	rs.b	1		; current BPM
+ms_RowHead	rs.b	1		; number of row events pushed, wraps at 256
+ms_TimerPeriod	rs.w	1		; latched timer A period in CIA ticks
+ms_TimerLoad	rs.w	1		; period of the running timer A interval
+ms_PauseDma	rs.w	1		; audio DMA channels to restart after a pause
+ms_TickTime	rs.l	1		; CIA ticks counted at timer A interrupts
+ms_PauseTime	rs.l	1		; tick clock at the last interrupt before a pause
+ms_RowEvents	rs.b	re_sizeof*ms_NumRowEvents
+	endc
+
+	ifd	MS_PROFILE
+ms_ProfMax	rs.l	1		; most color clocks spent in one replay
+ms_ProfHist	rs.w	ms_NumProfBuckets ; replays by 256 color clocks spent
 	endc
 
 mt_data:
@@ -3075,19 +3522,39 @@ _mt_MusicChannels:
 	ds.b	1
 
 	ifd	MODSURFER
-	xdef	_ms_StepCount
-_ms_StepCount:
-	ds.b	1
 	xdef	_ms_HoldRows
 _ms_HoldRows:
 	ds.b	1
-	xdef	_ms_SuppressSample
-_ms_SuppressSample:
-	ds.b	1
-_ms_SuppressNext:
-	ds.b	1
 _ms_BeatsPerMin:
 	ds.b	1
+	xdef	_ms_RowHead
+_ms_RowHead:
+	ds.b	1
+	xdef	_ms_TimerPeriod
+_ms_TimerPeriod:
+	ds.w	1
+	xdef	_ms_TimerLoad
+_ms_TimerLoad:
+	ds.w	1
+_ms_PauseDma:
+	ds.w	1
+	xdef	_ms_TickTime
+_ms_TickTime:
+	ds.l	1
+_ms_PauseTime:
+	ds.l	1
+	xdef	_ms_RowEvents
+_ms_RowEvents:
+	ds.b	re_sizeof*ms_NumRowEvents
+	endc
+
+	ifd	MS_PROFILE
+	xdef	_ms_ProfMax
+_ms_ProfMax:
+	ds.l	1
+	xdef	_ms_ProfHist
+_ms_ProfHist:
+	ds.w	ms_NumProfBuckets
 	endc
 
 	endc	; SDATA/!SDATA
@@ -3,6 +3,27 @@
 #include <exec/types.h>
 #include <hardware/custom.h>
 
+#define kNumRowEvents 16 // Must match ms_NumRowEvents
+
+// Ticks, speed and tempo include any Fxx command on the row itself.
+typedef struct {
+  ULONG time;      // ms_TickTime at the start of the row
+  ULONG ticks;     // Length of the row in CIA ticks
+  UBYTE song_pos;
+  UBYTE row;
+  UBYTE speed;     // Ticks per row
+  UBYTE tempo;     // Beats per minute
+} RowEvent;
+
+typedef struct {
+  APTR sfx_ptr;    // Sample start in chip RAM
+  UWORD sfx_len;   // Length in words
+  UWORD sfx_per;
+  UWORD sfx_vol;
+  BYTE sfx_cha;    // -1 selects the best channel
+  UBYTE sfx_pri;
+} SfxStructure;
+
 extern void mt_install_cia(volatile struct Custom* custom __asm("a6"),
                            APTR *AutoVecBase __asm("a0"),
                            UBYTE PALflag __asm("d0"));
@@ -15,9 +36,28 @@ extern void mt_end(volatile struct Custom* custom __asm("a6"));
 extern void mt_mastervol(volatile struct Custom* custom __asm("a6"),
                          UWORD MasterVolume __asm("d0"));
 extern void mt_music();
-extern UWORD ms_camera_z_inc(UWORD block_gap_depth __asm("d0"));
+extern void mt_playfx(volatile struct Custom* custom __asm("a6"),
+                      SfxStructure* SfxStructurePointer __asm("a0"));
+extern void ms_suppress(volatile struct Custom* custom __asm("a6"),
+                        UWORD channel __asm("d0"),
+                        UBYTE sample __asm("d1"));
+extern void ms_unmute(volatile struct Custom* custom __asm("a6"),
+                      UWORD channel __asm("d0"));
+extern void ms_pause(volatile struct Custom* custom __asm("a6"));
+extern ULONG ms_resume(volatile struct Custom* custom __asm("a6"),
+                       ULONG now __asm("d0"));
 
 extern volatile UBYTE mt_Enable;
-extern volatile UBYTE ms_StepCount;
 extern volatile UBYTE ms_HoldRows;
-extern volatile UBYTE ms_SuppressSample;
+extern volatile UBYTE ms_RowHead;
+extern volatile UWORD ms_TimerPeriod;
+extern volatile UWORD ms_TimerLoad;
+extern volatile ULONG ms_TickTime;
+extern volatile RowEvent ms_RowEvents[kNumRowEvents];
+
+#ifdef MS_PROFILE
+#define kNumProfBuckets 32 // Replays by 256 color clocks (512 CPU cycles) spent
+
+extern volatile ULONG ms_ProfMax;
+extern volatile UWORD ms_ProfHist[kNumProfBuckets];
+#endif
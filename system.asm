@@ -7,9 +7,12 @@ CIAICR_SP_BIT		= 3
 CIACRA_SPMODE 		= 1<<6
 INTREQ_PORTS		= 1<<3
 INTREQR_PORTS_BIT	= 3
+INTREQ_COPER_VERTB	= (1<<4)|(1<<5)
 
 	section	code
 	public	_level2_int
+	public	_level3_int
+	public	_level3_handler
 	public	_keyboard_state
 
 _level2_int:
@@ -57,5 +60,29 @@ _level2_int:
 	movem.l	(sp)+,d0-d1/a0-a2
 	rte
 
+_level3_int:
+	movem.l	d0-d1/a0-a1,-(sp)
+
+	;; Acknowledge COPER/VERTB interrupts, leaving BLIT untouched.
+	;; Repeat twice to work around A4000 040/060 bug.
+	lea	CUSTOM,a0
+	move.w	INTREQR(a0),d0
+	and.w	#INTREQ_COPER_VERTB,d0
+	move.w	d0,INTREQ(a0)
+	move.w	d0,INTREQ(a0)
+
+	;; Pass the acknowledged bits in d0 to the installed handler, if any.
+	move.l	_level3_handler,d1
+	beq	.no_handler
+	move.l	d1,a1
+	jsr	(a1)
+
+.no_handler:
+	movem.l	(sp)+,d0-d1/a0-a1
+	rte
+
+_level3_handler:
+	dc.l	0
+
 _keyboard_state:
 	ds.b	$80
@@ -1,4 +1,5 @@
 #include "system.h"
+#include "blit.h"
 #include "custom.h"
 #include "gfx.h"
 #include "ptplayer/ptplayer.h"
@@ -10,6 +11,7 @@
 #include <dos/filehandler.h>
 #include <exec/execbase.h>
 #include <graphics/gfxbase.h>
+#include <hardware/intbits.h>
 #include <proto/dos.h>
 #include <proto/exec.h>
 #include <proto/graphics.h>
@@ -18,13 +20,23 @@
 #define kLibVerKick1 33
 #define kLibVerKick3 39
 #define kVBRLvl2IntOffset 0x68
+#define kVBRLvl3IntOffset 0x6C
+#define kEClockPAL 709379
+#define kEClockNTSC 715909
+#define kLastLinePAL 0x137  // Last line of a short frame
+#define kLastLineNTSC 0x105 // ^-
+#define kNumMeasureFrames 4
 
 // Defined in system.asm
 extern void level2_int();
+extern void level3_int();
+extern void (*level3_handler)(UWORD intreq __asm("d0"));
 
 static void allow_task_switch(BOOL allow);
 static ULONG get_vbr();
 static void set_intreq(UWORD intreq);
+static void measure_frame_ticks();
+static UWORD beam_line();
 
 struct GfxBase* GfxBase;
 struct IntuitionBase* IntuitionBase;
@@ -39,12 +51,19 @@ static struct {
   BOOL input_handler_added;
   BOOL task_switch_disabled;
   BOOL blitter_owned;
+  struct Interrupt blit_int;
+  struct Interrupt* save_blit_int;
+  UWORD save_intena_blit;
   UWORD save_copcon;
   UWORD save_dmacon;
   struct View* save_view;
   UWORD save_intena;
   UWORD save_intreq;
   ULONG save_vbr_lvl2;
+  ULONG save_vbr_lvl3;
+  BOOL pal_clock;
+  BOOL pal_display;
+  UWORD frame_ticks;
 } g;
 
 Status system_init() {
@@ -53,6 +72,12 @@ Status system_init() {
   ASSERT(GfxBase = (struct GfxBase*)OpenLibrary("graphics.library", kLibVerKick1));
   ASSERT(IntuitionBase = (struct IntuitionBase*)OpenLibrary("intuition.library", kLibVerKick1));
 
+  // CIA E clock follows the crystal, the beam follows the display mode.
+  // Kickstart 3 tells them apart when the boot menu switched Agnus to the other mode.
+  g.pal_display = (GfxBase->DisplayFlags & PAL) != 0;
+  g.pal_clock = (GfxBase->LibNode.lib_Version >= kLibVerKick3) ?
+                ((GfxBase->DisplayFlags & REALLY_PAL) != 0) : g.pal_display;
+
   if (! system_is_rtg()) {
     g.wb_closed = CloseWorkBench();
   }
@@ -91,24 +116,32 @@ void system_fini() {
   }
 }
 
-void system_print_error(STRPTR msg) {
+void system_print(STRPTR msg) {
   // DOS needs task switching to handle Write request.
   // Console needs blitter to draw text.
   if (DOSBase && (! g.task_switch_disabled)) {
     // Let OS temporarily use blitter to draw into console.
     system_release_blitter();
 
-    STRPTR out_strs[] = {"modsurfer: assert(", msg, ") failed\n"};
+    // No output stream when started from Workbench.
     BPTR out_handle = Output();
 
-    for (UWORD i = 0; i < ARRAY_NELEMS(out_strs); ++ i) {
-      Write(out_handle, out_strs[i], string_length(out_strs[i]));
+    if (out_handle) {
+      Write(out_handle, msg, string_length(msg));
     }
 
     system_acquire_blitter();
   }
 }
 
+void system_print_error(STRPTR msg) {
+  STRPTR out_strs[] = {"modsurfer: assert(", msg, ") failed\n"};
+
+  for (UWORD i = 0; i < ARRAY_NELEMS(out_strs); ++ i) {
+    system_print(out_strs[i]);
+  }
+}
+
 Status system_time_micros(ULONG* time_micros) {
   Status status = StatusOK;
   struct MsgPort* port = NULL;
@@ -306,7 +339,8 @@ void system_acquire_control() {
 
   // Wait for any in-flight blits to complete.
   // Our new copperlist expects exclusive access to the blitter.
-  gfx_wait_blit();
+  // Blits are synchronous while we have control, the copper also starts them.
+  blit_set_async(FALSE);
 
   // Save and enable copper access to blitter registers.
   g.save_copcon = custom.copcon;
@@ -333,25 +367,66 @@ void system_acquire_control() {
   g.save_vbr_lvl2 = *vbr_lvl2;
   *vbr_lvl2 = (ULONG)level2_int;
 
-  // Enable PORTS interrupts for level 2 handler.
-  custom.intena = INTENA_SET | INTENA_PORTS;
+  // Save and replace level 3 interrupt handler, which calls any installed handler.
+  volatile ULONG* vbr_lvl3 = (volatile ULONG*)(vbr + kVBRLvl3IntOffset);
+
+  level3_handler = NULL;
+  g.save_vbr_lvl3 = *vbr_lvl3;
+  *vbr_lvl3 = (ULONG)level3_int;
+
+  // Enable PORTS interrupts for level 2 handler, COPER/VERTB for level 3.
+  custom.intena = INTENA_SET | INTENA_PORTS | INTENA_COPER | INTENA_VERTB;
 
   // Install ptplayer interrupt handlers.
-  mt_install_cia(&custom, (APTR)vbr, 1);
+  mt_install_cia(&custom, (APTR)vbr, g.pal_clock);
+
+  // Display mode won't change while we run, measure the frame period once.
+  if (g.frame_ticks == 0) {
+    measure_frame_ticks();
+  }
+}
+
+static void measure_frame_ticks() {
+  // Time whole frames on the tick clock, from one wrap of the beam to the next.
+  ULONG start_time = 0;
+  UWORD line = beam_line();
+
+  for (UWORD wraps = 0; wraps <= kNumMeasureFrames; ++ wraps) {
+    UWORD prev_line = 0;
+
+    do {
+      prev_line = line;
+      line = beam_line();
+    } while (line >= prev_line);
+
+    if (wraps == 0) {
+      start_time = system_tick_clock();
+    }
+  }
+
+  g.frame_ticks = (system_tick_clock() - start_time) / kNumMeasureFrames;
+}
+
+static UWORD beam_line() {
+  ULONG vpos_vhpos = *(volatile ULONG*)&custom.vposr;
+  return (vpos_vhpos >> 8) & 0x1FF;
 }
 
 void system_release_control() {
   // Remove ptplayer interrupt handlers.
   mt_remove_cia(&custom);
 
-  // Disable PORTS interrupts.
-  custom.intena = INTENA_PORTS;
+  // Disable PORTS and COPER/VERTB interrupts.
+  custom.intena = INTENA_PORTS | INTENA_COPER | INTENA_VERTB;
+  level3_handler = NULL;
 
-  // Restore level 2 interrupt handler.
+  // Restore level 2 and 3 interrupt handlers.
   ULONG vbr = get_vbr();
   volatile ULONG* vbr_lvl2 = (volatile ULONG*)(vbr + kVBRLvl2IntOffset);
+  volatile ULONG* vbr_lvl3 = (volatile ULONG*)(vbr + kVBRLvl3IntOffset);
 
   *vbr_lvl2 = g.save_vbr_lvl2;
+  *vbr_lvl3 = g.save_vbr_lvl3;
 
   // Restore interrupt state.
   set_intreq(INTREQ_CLEARALL);
@@ -370,6 +445,9 @@ void system_release_control() {
   // Restore copper access to blitter registers.
   custom.copcon = g.save_copcon;
 
+  // Resume queueing blits if the blitter interrupt is ours again.
+  blit_set_async(g.blitter_owned);
+
   // Restore primary copperlist pointer.
   custom.cop1lc = (ULONG)GfxBase->copinit;
 
@@ -388,6 +466,11 @@ static void allow_task_switch(BOOL allow) {
   }
 }
 
+void system_set_level3_handler(void (*handler)(UWORD intreq __asm("d0"))) {
+  // Called with COPER/VERTB request bits while control is acquired.
+  level3_handler = handler;
+}
+
 static ULONG get_vbr() {
   // VBR is 0 on 68000, supervisor register on 68010+.
   ULONG vbr = 0;
@@ -411,12 +494,33 @@ void system_acquire_blitter() {
   if (! g.blitter_owned) {
     g.blitter_owned = TRUE;
     OwnBlitter();
+
+    // Take over the blitter interrupt from graphics.library to drain our queue.
+    // The previous owner's last blit may still be running.
+    blit_fence();
+
+    g.blit_int.is_Node.ln_Name = "ModSurfer";
+    g.blit_int.is_Code = blit_int;
+    g.save_intena_blit = custom.intenar & INTENA_BLIT;
+    custom.intena = INTENA_BLIT;
+    g.save_blit_int = SetIntVector(INTB_BLIT, &g.blit_int);
+
+    set_intreq(INTREQ_BLIT);
+    custom.intena = INTENA_SET | INTENA_BLIT;
+    blit_set_async(TRUE);
   }
 }
 
 void system_release_blitter() {
   if (g.blitter_owned) {
     g.blitter_owned = FALSE;
+
+    // Drain the queue before handing the interrupt back.
+    blit_set_async(FALSE);
+    custom.intena = INTENA_BLIT;
+    SetIntVector(INTB_BLIT, g.save_blit_int);
+    custom.intena = INTENA_SET | g.save_intena_blit;
+
     DisownBlitter();
   }
 }
@@ -436,4 +540,41 @@ BOOL system_is_rtg() {
   }
 
   return is_rtg;
-}
\ No newline at end of file
+}
+
+BOOL system_is_aga() {
+  return (GfxBase->ChipRevBits0 & GFXF_AA_ALICE) != 0;
+}
+
+UWORD system_frame_ticks() {
+  // CIA ticks per displayed frame, valid once control has been acquired.
+  return g.frame_ticks;
+}
+
+UWORD system_ticks_per_milli() {
+  return (g.pal_clock ? kEClockPAL : kEClockNTSC) / 1000;
+}
+
+UWORD system_last_line() {
+  // Last beam line of every frame, beyond the bottom of a PAL display on NTSC.
+  return g.pal_display ? kLastLinePAL : kLastLineNTSC;
+}
+
+ULONG system_tick_clock() {
+  // CIA ticks counted by ptplayer's timer A, valid while control is acquired.
+  ULONG base_time = 0;
+  UWORD load = 0;
+  UWORD count = 0;
+  UBYTE count_hi = 0;
+
+  // Retry if the timer A interrupt or a borrow into the high byte intervened.
+  do {
+    base_time = ms_TickTime;
+    load = ms_TimerLoad;
+    count_hi = ciab.ciatahi;
+    count = (count_hi << 8) | ciab.ciatalo;
+  } while ((ciab.ciatahi != count_hi) || (ms_TickTime != base_time));
+
+  // Timer counts down from the loaded period and interrupts at zero.
+  return base_time + ((count <= load) ? (load - count) : 0);
+}
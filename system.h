@@ -6,12 +6,16 @@
 #include <graphics/view.h>
 
 #define kNumKeycodes 0x80
+#define kKeycodeP 0x19
 #define kKeycodeA 0x20
 #define kKeycodeD 0x22
+#define kKeycodeSpace 0x40
 #define kKeycodeEsc 0x45
+#define kKeycodeHelp 0x5F
 
 extern Status system_init();
 extern void system_fini();
+extern void system_print(STRPTR msg);
 extern void system_print_error(STRPTR msg);
 extern Status system_time_micros(ULONG* time_micros);  // SystemError
 extern Status system_add_input_handler(APTR handler_func,
@@ -26,6 +30,12 @@ extern void system_acquire_control();
 extern void system_release_control();
 extern void system_acquire_blitter();
 extern void system_release_blitter();
+extern void system_set_level3_handler(void (*handler)(UWORD intreq __asm("d0")));
 extern BOOL system_is_rtg();
+extern BOOL system_is_aga();
+extern ULONG system_tick_clock();
+extern UWORD system_frame_ticks();
+extern UWORD system_ticks_per_milli();
+extern UWORD system_last_line();
 
 extern volatile UBYTE keyboard_state[kNumKeycodes];
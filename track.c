@@ -3,16 +3,20 @@
 #include "dtypes.h"
 #include "module.h"
 
-#define kPeriodTableSize 857 // C-1 = 856
 #define kFirstSampleNum 1  // Protracker uses samples 1-31
 #define kFFTImag 0
 #define kFFTReal 1
+#define kEffectTonePortaVolSlide 0x5
+#define kEffectVibratoVolSlide 0x6
+#define kEffectVolSlide 0xA
 #define kEffectPosJump 0xB
 #define kEffectSetVolume 0xC
 #define kEffectPatBreak 0xD
 #define kEffectExtend 0xE
 #define kEffectSetSpeed 0xF
 #define kEffectExtPatLoop 0x6
+#define kEffectExtFineVolUp 0xA
+#define kEffectExtFineVolDown 0xB
 #define kEffectExtPatDelay 0xE
 #define kCountTargetMin1 16
 #define kCountTargetMin2 4
@@ -22,6 +26,25 @@
 #define kScorePitchWeight 2
 #define kDefaultBeatsPerMin 125
 #define kDefaultTicksPerDiv 6
+#define kEasyMinGap 2
+#define kMaxVolume 0x40
+#define kAttackLength 0x100
+#define kOnsetMinLevel 0x10
+#define kLaneBits 2
+#define kLaneMask 3
+#define kChannelShift (kNumTrackTiers * kLaneBits) // Source channel above tier lanes
+
+typedef struct {
+  UWORD active_contiguous_count;
+  UWORD last_active_lane;
+  UWORD since_last_active;
+} TierState;
+
+typedef struct {
+  UBYTE sample;    // Last sample number on the channel
+  UBYTE volume;    // 0 to kMaxVolume
+  UWORD envelope;  // Decaying onset level, 8.8 fixed point
+} ChannelState;
 
 typedef struct {
   UWORD pat_tbl_idx;
@@ -29,9 +52,8 @@ typedef struct {
   UWORD div_start_idx;
   UWORD loop_idx[4];
   UWORD loop_count[4];
-  UWORD active_contiguous_count;
-  UWORD last_active_lane;
-  UWORD since_last_active;
+  TierState tiers[kNumTrackTiers];
+  ChannelState channels[4];
   UWORD beats_per_min;
   UWORD ticks_per_div;
   UWORD speed;
@@ -45,67 +67,63 @@ static void apply_fft();
 static WORD fix_mult(WORD a,
                      WORD b);
 static void find_dominant_freq(UWORD samp_idx);
+static void measure_attack(BYTE* samples,
+                           ULONG samp_size_b,
+                           UWORD samp_idx);
 static void count_samples(UWORD pat_idx);
 static BOOL skip_command(PatternCommand* cmd);
 static void select_lead_sample(UWORD pat_idx);
 static Status pad_visible(BOOL lead_in);
+static Status append_step(TrackStep* step,
+                          UBYTE lanes);
 static Status walk_pattern_table();
 static Status walk_pattern(UWORD pat_idx,
                            BuildState* state);
 static Status make_step(PatternDivision* div,
                         BuildState* state,
-                        ULONG select_samples);
+                        ULONG lead_samples,
+                        ULONG extra_samples);
+static BOOL detect_onset(PatternCommand* cmd,
+                         ChannelState* chan,
+                         UWORD ticks_per_div);
+static UWORD next_lane(TierState* tier,
+                       BuildState* state,
+                       BOOL block);
 static Status handle_commands(PatternDivision* div,
                               BuildState* state);
 
 static struct {
   vector_t track_steps;
+  vector_t track_lanes;
   UWORD track_num_blocks;
+  UWORD tier_num_blocks[kNumTrackTiers];
   ULONG pat_select_samples[kNumPatternsMax];
-  UBYTE period_to_color[kPeriodTableSize];
+  ULONG pat_extra_samples[kNumPatternsMax];
+  UWORD pos_step_idx[kSongMaxLen]; // First step of each song position, 0 if unplayable
   UWORD samp_dom_freq[kNumSamplesMax];
+  UBYTE samp_attack[kNumSamplesMax];
   UBYTE samp_count[kNumSamplesMax];
   ULONG samp_period_sum[kNumSamplesMax];
   WORD fft_data[2][kFFTSize];
 } g;
 
-void track_init() {
-  // Protracker periods with 0 finetune.
-  // These are matched with notes in the module to color blocks by pitch.
-  UWORD period_table[] = {
-  // C    C#   D    D#   E    F    F#   G    G#   A    A#   B
-    856, 808, 762, 720, 678, 640, 604, 570, 538, 508, 480, 453, // Octave 1
-    428, 404, 381, 360, 339, 320, 302, 285, 269, 254, 240, 226, // Octave 2
-    214, 202, 190, 180, 170, 160, 151, 143, 135, 127, 120, 113, // Octave 3
-    0,
-  };
-
-  UWORD period_idx = 0;
-  UWORD next_period = period_table[period_idx];
-  UWORD next_color = 0;
-
-  // Loop over all periods in descending order (ascending pitch).
-  for (WORD period = kPeriodTableSize - 1; period >= 0; -- period) {
-    // Maintain the color until we reach the next Protracker note.
-    if (period == next_period) {
-      next_color = period_idx / ((ARRAY_NELEMS(period_table) - 1) / kNumBlockColors);
-
-      ++ period_idx;
-      next_period = period_table[period_idx];
-    }
-
-    g.period_to_color[period] = next_color;
-  }
-}
-
 Status track_build() {
   Status status = StatusOK;
 
   ASSERT(vector_size(&g.track_steps) == 0);
   vector_init(sizeof(TrackStep), &g.track_steps);
+  vector_init(sizeof(UBYTE), &g.track_lanes);
 
   g.track_num_blocks = 0;
 
+  for (UWORD tier = 0; tier < kNumTrackTiers; ++ tier) {
+    g.tier_num_blocks[tier] = 0;
+  }
+
+  for (UWORD i = 0; i < kSongMaxLen; ++ i) {
+    g.pos_step_idx[i] = 0;
+  }
+
   // Choose samples in each pattern to correspond with blocks.
   select_samples();
 
@@ -113,6 +131,7 @@ Status track_build() {
   CATCH(pad_visible(TRUE), 0);
 
   // Create steps for every division in the song, in playback order.
+  // Lanes for all difficulty tiers are chosen in the same pass.
   CATCH(walk_pattern_table(), 0);
 
   // Finish with empty steps covering the visible track.
@@ -147,12 +166,14 @@ static void analyze_samples() {
     // Zero-sized samples are not used in the module.
     if (samp_size_b == 0) {
       g.samp_dom_freq[samp_idx] = 0;
+      g.samp_attack[samp_idx] = 0;
       continue;
     }
 
     real_to_fft_input(next_sample, samp_size_b);
     apply_fft();
     find_dominant_freq(samp_idx);
+    measure_attack(next_sample, samp_size_b, samp_idx);
 
     next_sample += samp_size_b;
   }
@@ -240,6 +261,23 @@ static void find_dominant_freq(UWORD samp_idx) {
   g.samp_dom_freq[samp_idx] = dom_freq_idx;
 }
 
+static void measure_attack(BYTE* samples,
+                           ULONG samp_size_b,
+                           UWORD samp_idx) {
+  // Mean amplitude over the start of the sample, where the note is heard.
+  // Skip the first word which Protracker zeroes for looping.
+  UWORD attack_length = MIN(samp_size_b - 2, kAttackLength);
+  ULONG amplitude_sum = 0;
+
+  for (UWORD i = 0; i < attack_length; ++ i) {
+    amplitude_sum += ABS(samples[i + 2]);
+  }
+
+  // Scale so a mean amplitude of a quarter of full range or more is full attack.
+  UWORD mean_amplitude = attack_length ? (amplitude_sum / attack_length) : 0;
+  g.samp_attack[samp_idx] = MIN(mean_amplitude * 2, kMaxVolume);
+}
+
 static void count_samples(UWORD pat_idx) {
   ModuleNonChip* nonchip = module_nonchip();
   Pattern* pat = &nonchip->patterns[pat_idx];
@@ -294,6 +332,8 @@ static BOOL skip_command(PatternCommand* cmd) {
 static void select_lead_sample(UWORD pat_idx) {
   UWORD best_samp_idx = 0;
   ULONG best_score = (ULONG)-1;
+  UWORD second_samp_idx = kNumSamplesMax;
+  ULONG second_score = (ULONG)-1;
 
   for (UWORD samp_idx = 0; samp_idx < kNumSamplesMax; ++ samp_idx) {
     if (g.samp_count[samp_idx] > 0) {
@@ -314,30 +354,56 @@ static void select_lead_sample(UWORD pat_idx) {
       UWORD score_pitch = ABS(pitch - kPitchTarget);
       ULONG score = (score_count * kScoreCountWeight) + (score_pitch * kScorePitchWeight);
 
+      // Runner-up sample adds extra blocks in the hard tier.
       if (score < best_score) {
+        if (best_score != (ULONG)-1) {
+          second_score = best_score;
+          second_samp_idx = best_samp_idx;
+        }
+
         best_score = score;
         best_samp_idx = samp_idx;
       }
+      else if (score < second_score) {
+        second_score = score;
+        second_samp_idx = samp_idx;
+      }
     }
   }
 
   g.pat_select_samples[pat_idx] = 1UL << (best_samp_idx + kFirstSampleNum);
+  g.pat_extra_samples[pat_idx] = 0;
+
+  if (second_samp_idx < kNumSamplesMax) {
+    g.pat_extra_samples[pat_idx] = 1UL << (second_samp_idx + kFirstSampleNum);
+  }
 }
 
 static Status pad_visible(BOOL lead_in) {
   Status status = StatusOK;
 
-  UWORD num_steps = lead_in ? kNumVisibleSteps : kNumPaddingSteps;
+  UWORD num_steps = lead_in ? kMaxVisibleSteps : kNumPaddingSteps;
   TrackStep step = {0};
 
   for (UWORD i = 0; i < num_steps; ++ i) {
-    CATCH(vector_append(&g.track_steps, 1, &step), 0);
+    CATCH(append_step(&step, 0), 0);
   }
 
 cleanup:
   return status;
 }
 
+static Status append_step(TrackStep* step,
+                          UBYTE lanes) {
+  Status status = StatusOK;
+
+  CATCH(vector_append(&g.track_steps, 1, step), 0);
+  CATCH(vector_append(&g.track_lanes, 1, &lanes), 0);
+
+cleanup:
+  return status;
+}
+
 static Status walk_pattern_table() {
   Status status = StatusOK;
   ModuleNonChip* nonchip = module_nonchip();
@@ -366,6 +432,11 @@ static Status walk_pattern_table() {
 
     pat_tbl_visited[state.pat_tbl_idx] = 1;
 
+    // ptplayer can only start a position from its first division.
+    if (state.div_start_idx == 0) {
+      g.pos_step_idx[state.pat_tbl_idx] = (UWORD)vector_size(&g.track_steps);
+    }
+
     // Increment here because walk_pattern may overwrite with a different pattern.
     ++ state.pat_tbl_idx;
 
@@ -382,7 +453,8 @@ static Status walk_pattern(UWORD pat_idx,
   ModuleNonChip* nonchip = module_nonchip();
   Pattern* pat = &nonchip->patterns[pat_idx];
 
-  ULONG select_samples = g.pat_select_samples[pat_idx];
+  ULONG lead_samples = g.pat_select_samples[pat_idx];
+  ULONG extra_samples = g.pat_extra_samples[pat_idx];
 
   for (UWORD i = 0; i < 4; ++ i) {
     state->loop_idx[i] = 0;
@@ -396,7 +468,7 @@ static Status walk_pattern(UWORD pat_idx,
   while (state->div_idx < kDivsPerPattern) {
     PatternDivision* div = &pat->divisions[state->div_idx];
 
-    CATCH(make_step(div, state, select_samples), 0);
+    CATCH(make_step(div, state, lead_samples, extra_samples), 0);
     CATCH(handle_commands(div, state), 0);
   }
 
@@ -406,42 +478,153 @@ cleanup:
 
 Status make_step(PatternDivision* div,
                  BuildState* state,
-                 ULONG select_samples) {
+                 ULONG lead_samples,
+                 ULONG extra_samples) {
   Status status = StatusOK;
-  UBYTE sample_in_step = 0;
-  UBYTE step_color = 0;
+  ModuleNonChip* nonchip = module_nonchip();
+  UBYTE lead_sample = 0;
+  UBYTE lead_color = 0;
+  UBYTE lead_channel = 0;
+  UBYTE extra_sample = 0;
+  UBYTE extra_color = 0;
+  UBYTE extra_channel = 0;
 
   for (UWORD cmd_idx = 0; cmd_idx < 4; ++ cmd_idx) {
     PatternCommand* cmd = (PatternCommand*)&div->commands[cmd_idx];
+    ChannelState* chan = &state->channels[cmd_idx];
 
-    if (skip_command(cmd)) {
+    // Only audible accents are candidates for blocks.
+    if (! detect_onset(cmd, chan, state->ticks_per_div)) {
       continue;
     }
 
-    static UBYTE last_sample[4] = {0};
-    UBYTE sample = (cmd->sample_hi << 4) | cmd->sample_lo;
+    UBYTE sample = chan->sample;
+    UWORD period = cmd->parameter;
 
-    if (! sample) {
-      sample = last_sample[cmd_idx];
+    if ((lead_samples | extra_samples) & (1UL << sample)) {
+      // Color blocks by pitch, using the note period table for the sample's finetune.
+      UBYTE finetune = nonchip->header.sample_info[sample - kFirstSampleNum].finetune & 0xF;
+      UBYTE note = PeriodToNote[finetune][MIN(period, kPeriodTableSize - 1)];
+
+      if (lead_samples & (1UL << sample)) {
+        lead_sample = sample;
+        lead_color = NoteToColor[note];
+        lead_channel = cmd_idx;
+      }
+      else {
+        extra_sample = sample;
+        extra_color = NoteToColor[note];
+        extra_channel = cmd_idx;
+      }
     }
-    else {
-      last_sample[cmd_idx] = sample;
+  }
+
+  TrackStep step = {0};
+  UBYTE channel = 0;
+
+  // Lead sample takes priority over the runner-up for sound and color.
+  if (lead_sample != 0) {
+    step.sample = lead_sample;
+    step.color = lead_color;
+    channel = lead_channel;
+  }
+  else if (extra_sample != 0) {
+    step.sample = extra_sample;
+    step.color = extra_color;
+    channel = extra_channel;
+  }
+
+  // Easy thins out runs of lead blocks, hard adds the runner-up sample.
+  BOOL tier_blocks[kNumTrackTiers] = {
+    [TrackTierEasy] = (lead_sample != 0) &&
+                      (state->tiers[TrackTierEasy].since_last_active >= kEasyMinGap),
+    [TrackTierNormal] = (lead_sample != 0),
+    [TrackTierHard] = (step.sample != 0),
+  };
+
+  // Remember which channel plays the sample, so only that channel is suppressed.
+  UBYTE lanes = channel << kChannelShift;
+
+  for (UWORD tier = 0; tier < kNumTrackTiers; ++ tier) {
+    UWORD lane = next_lane(&state->tiers[tier], state, tier_blocks[tier]);
+
+    if (tier_blocks[tier]) {
+      ++ g.tier_num_blocks[tier];
     }
 
-    UWORD period = cmd->parameter;
+    lanes |= lane << (tier * kLaneBits);
+  }
+
+  CATCH(append_step(&step, lanes), 0);
 
-    if (period && sample && (select_samples & (1UL << sample))) {
-      sample_in_step = sample;
-      step_color = g.period_to_color[period];
+cleanup:
+  return status;
+}
+
+static BOOL detect_onset(PatternCommand* cmd,
+                         ChannelState* chan,
+                         UWORD ticks_per_div) {
+  ModuleNonChip* nonchip = module_nonchip();
+  UBYTE sample = (cmd->sample_hi << 4) | cmd->sample_lo;
+  UWORD effect_major = cmd->effect >> 8;
+  UBYTE effect_param = cmd->effect & 0xFF;
+  WORD volume = chan->volume;
+  BOOL onset = FALSE;
+
+  // Envelope decays over the ticks of the previous division.
+  chan->envelope = ((ULONG)chan->envelope * EnvelopeDecay[ticks_per_div]) >> 8;
+
+  // A sample number resets the channel to the sample's default volume.
+  if (sample) {
+    chan->sample = sample;
+    volume = nonchip->header.sample_info[sample - kFirstSampleNum].volume;
+  }
+
+  // Volume set on the first tick is heard with the note.
+  if (effect_major == kEffectSetVolume) {
+    volume = effect_param;
+  }
+  else if (effect_major == kEffectExtend) {
+    if ((effect_param >> 4) == kEffectExtFineVolUp) {
+      volume += effect_param & 0xF;
+    }
+    else if ((effect_param >> 4) == kEffectExtFineVolDown) {
+      volume -= effect_param & 0xF;
     }
   }
 
-  TrackStep step = {0};
+  volume = MAX(0, MIN(kMaxVolume, volume));
+
+  if (cmd->parameter && chan->sample) {
+    // Level scales channel volume by the sample's attack, both out of kMaxVolume.
+    UWORD level = (volume * g.samp_attack[chan->sample - kFirstSampleNum]) / kMaxVolume;
+
+    // Accent must be loud enough and not masked by recent notes on the channel.
+    UWORD masking = (chan->envelope >> 8) - (chan->envelope >> 10);
+    onset = (level >= kOnsetMinLevel) && (level > masking);
 
-  if (sample_in_step != 0) {
-    step.sample = sample_in_step;
-    step.color = step_color;
+    chan->envelope = MAX(chan->envelope, level << 8);
+  }
+
+  // Volume slides apply on the remaining ticks of the division.
+  if ((effect_major == kEffectVolSlide) ||
+      (effect_major == kEffectTonePortaVolSlide) ||
+      (effect_major == kEffectVibratoVolSlide)) {
+    WORD slide = (effect_param >> 4) ? (effect_param >> 4) : -(effect_param & 0xF);
+    volume = MAX(0, MIN(kMaxVolume, volume + (slide * (ticks_per_div - 1))));
+  }
+
+  chan->volume = volume;
+
+  return onset;
+}
 
+static UWORD next_lane(TierState* tier,
+                       BuildState* state,
+                       BOOL block) {
+  UWORD lane = 0;
+
+  if (block) {
     static UWORD next_lane_lut[4][4] = {
       // Row indexed by last active lane, column indexed by random number.
       2, 1, 2, 3,
@@ -452,12 +635,12 @@ Status make_step(PatternDivision* div,
 
     UWORD random4 = random_mod4();
 
-    if (state->active_contiguous_count == 1) {
+    if (tier->active_contiguous_count == 1) {
       // Avoid lane change in contiguous segments until length is >= 2.
       random4 = 0;
     }
 
-    if ((random4 == 3) && (state->last_active_lane != 2) && state->active_contiguous_count) {
+    if ((random4 == 3) && (tier->last_active_lane != 2) && tier->active_contiguous_count) {
       // Avoid left-right and right-left lane changes in contiguous segments.
       random4 = 0;
     }
@@ -465,31 +648,27 @@ Status make_step(PatternDivision* div,
     // Avoid left-right and right-left lane changes without a reasonable gap.
     // Only apply when the speed is above a threshold
     if ((random4 == 3) && (state->speed > 12000) &&
-        (state->last_active_lane != 2) && (state->since_last_active < 3)) {
+        (tier->last_active_lane != 2) && (tier->since_last_active < 3)) {
       random4 = 0;
     }
 
-    step.active_lane = next_lane_lut[state->last_active_lane][random4];
+    lane = next_lane_lut[tier->last_active_lane][random4];
 
-    if (step.active_lane != state->last_active_lane) {
-      state->last_active_lane = step.active_lane;
-      state->active_contiguous_count = 0;
+    if (lane != tier->last_active_lane) {
+      tier->last_active_lane = lane;
+      tier->active_contiguous_count = 0;
     }
 
-    state->since_last_active = 0;
-    ++ state->active_contiguous_count;
-    ++ g.track_num_blocks;
+    tier->since_last_active = 0;
+    ++ tier->active_contiguous_count;
   }
   else {
-    state->active_contiguous_count = 0;
+    tier->active_contiguous_count = 0;
   }
 
-  ++ state->since_last_active;
-
-  CATCH(vector_append(&g.track_steps, 1, &step), 0);
+  ++ tier->since_last_active;
 
-cleanup:
-  return status;
+  return lane;
 }
 
 Status handle_commands(PatternDivision* div,
@@ -578,7 +757,7 @@ Status handle_commands(PatternDivision* div,
   TrackStep delay_step = {0};
 
   for (UWORD i = 0; i < delay; ++ i) {
-    CATCH(vector_append(&g.track_steps, 1, &delay_step), 0);
+    CATCH(append_step(&delay_step, 0), 0);
   }
 
 cleanup:
@@ -587,12 +766,66 @@ cleanup:
 
 void track_free() {
   vector_free(&g.track_steps);
+  vector_free(&g.track_lanes);
+}
+
+BOOL track_is_built() {
+  return vector_size(&g.track_steps) != 0;
+}
+
+void track_select_tier(UWORD tier) {
+  TrackStep* steps = track_steps();
+  UBYTE* lanes = (UBYTE*)vector_elems(&g.track_lanes);
+  UWORD num_steps = (UWORD)vector_size(&g.track_steps);
+  UWORD lane_shift = tier * kLaneBits;
+
+  for (UWORD i = 0; i < num_steps; ++ i) {
+    steps[i].active_lane = (lanes[i] >> lane_shift) & kLaneMask;
+
+    // Restore the original color of blocks hit in a previous game.
+    if (steps[i].color >= kNumBlockColors) {
+      steps[i].color -= kNumBlockColors;
+    }
+  }
+
+  g.track_num_blocks = g.tier_num_blocks[tier];
+}
+
+UWORD track_start_pos(UWORD song_pos) {
+  // Nearest playable position at or before the requested one, the first always is.
+  while ((song_pos > 0) && (g.pos_step_idx[song_pos] == 0)) {
+    -- song_pos;
+  }
+
+  return song_pos;
+}
+
+UWORD track_select_start(UWORD song_pos,
+                         UWORD num_visible_steps) {
+  TrackStep* steps = track_steps();
+  UWORD start_step_idx = MAX(kMaxVisibleSteps, g.pos_step_idx[track_start_pos(song_pos)]);
+
+  // Hide blocks before the start, they scroll past during the lead-in.
+  for (UWORD i = kMaxVisibleSteps; i < start_step_idx; ++ i) {
+    if (steps[i].active_lane) {
+      steps[i].active_lane = 0;
+      -- g.track_num_blocks;
+    }
+  }
+
+  // Steps skipped so the start position follows the usual lead-in.
+  return start_step_idx - num_visible_steps;
 }
 
 TrackStep* track_steps() {
   return (TrackStep*)vector_elems(&g.track_steps);
 }
 
+UWORD track_step_channel(TrackStep* step) {
+  UBYTE* lanes = (UBYTE*)vector_elems(&g.track_lanes);
+  return lanes[step - track_steps()] >> kChannelShift;
+}
+
 UWORD track_unpadded_length() {
   return (UWORD)vector_size(&g.track_steps) - kNumPaddingSteps;
 }
@@ -2,10 +2,18 @@
 
 #include "common.h"
 
-#define kNumVisibleSteps 16
-#define kNumPaddingSteps (kNumVisibleSteps + 0x40) // 32 frame fade out at speed 1 BPM 255
+#define kNumVisibleSteps 16 // Default draw distance, see gfx_num_visible_steps
+#define kMaxVisibleSteps 20 // ^- furthest of any detail, sizes the padding
+#define kNumPaddingSteps (kMaxVisibleSteps + 0x40) // 32 frame fade out at speed 1 BPM 255
 #define kNumStepsDelay 1
 #define kNumBlockColors 12
+#define kNumTrackTiers 3
+
+enum {
+  TrackTierEasy,
+  TrackTierNormal,
+  TrackTierHard,
+};
 
 typedef struct {
   UWORD active_lane:2;
@@ -15,9 +23,14 @@ typedef struct {
   UWORD unused2:1;
 } TrackStep;
 
-void track_init();
 Status track_build();  // StatusError, StatusOutOfMemory
 void track_free();
+BOOL track_is_built();
+void track_select_tier(UWORD tier);
+UWORD track_start_pos(UWORD song_pos);
+UWORD track_select_start(UWORD song_pos,
+                         UWORD num_visible_steps);
 TrackStep* track_steps();
+UWORD track_step_channel(TrackStep* step);
 UWORD track_unpadded_length();
 UWORD track_num_blocks();